@@ -0,0 +1,46 @@
+#shader vertex
+#version 420 core
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec4 colour;
+layout(location = 3) in uint texIndex;
+
+out vec2 v_TexCoord;
+out vec4 v_Colour;
+flat out int v_TexIndex;
+
+void main()
+{
+	gl_Position = vec4(position, 0.0, 1.0);
+	v_TexCoord = texCoord;
+	v_Colour = colour;
+	v_TexIndex = int(texIndex);
+};
+
+
+#shader fragment
+#version 420 core
+
+// MAX_TEXTURES is defined by the BatchRenderer (GL_MAX_TEXTURE_IMAGE_UNITS, at most 32)
+layout(binding = 0) uniform sampler2D u_Textures[MAX_TEXTURES];	// unit i = slot i, slot 0 is plain white
+
+in vec2 v_TexCoord;
+in vec4 v_Colour;
+flat in int v_TexIndex;
+
+out vec4 colour;
+
+void main()
+{
+	// indexing a sampler array with a value that differs between fragments is undefined, a loop counter isn't.
+	// The derivatives are taken outside the branch for the same reason
+	vec2 dx = dFdx(v_TexCoord);
+	vec2 dy = dFdy(v_TexCoord);
+	vec4 texel = vec4(1.0);
+	for (int i = 0; i < MAX_TEXTURES; i++) {
+		if (i == v_TexIndex)
+			texel = textureGrad(u_Textures[i], v_TexCoord, dx, dy);
+	}
+	colour = v_Colour * texel;
+};
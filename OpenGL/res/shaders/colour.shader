@@ -0,0 +1,25 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec4 colour;
+
+out vec4 v_Colour;
+
+void main()
+{
+	gl_Position = position;
+	v_Colour = colour;
+};
+
+
+#shader fragment
+#version 330 core
+
+in vec4 v_Colour;
+out vec4 colour;
+
+void main()
+{
+	colour = v_Colour;
+};
@@ -0,0 +1,27 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+// per instance
+layout(location = 1) in vec4 colour;
+layout(location = 2) in mat4 transform;		// takes locations 2 to 5
+
+out vec4 v_Colour;
+
+void main()
+{
+	gl_Position = transform * position;
+	v_Colour = colour;
+};
+
+
+#shader fragment
+#version 330 core
+
+in vec4 v_Colour;
+out vec4 colour;
+
+void main()
+{
+	colour = v_Colour;
+};
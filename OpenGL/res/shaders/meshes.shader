@@ -0,0 +1,27 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec2 position;		// in the unit square
+// per draw
+layout(location = 1) in vec4 rect;			// x, y, width, height
+layout(location = 2) in vec4 colour;
+
+out vec4 v_Colour;
+
+void main()
+{
+	gl_Position = vec4(rect.xy + position * rect.zw, 0.0, 1.0);
+	v_Colour = colour;
+};
+
+
+#shader fragment
+#version 330 core
+
+in vec4 v_Colour;
+out vec4 colour;
+
+void main()
+{
+	colour = v_Colour;
+};
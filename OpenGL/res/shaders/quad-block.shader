@@ -0,0 +1,31 @@
+#shader vertex
+#version 420 core
+
+layout(location = 0) in vec4 position;
+
+// per draw, a range of the UniformBuffer bound with glBindBufferRange
+layout(std140, binding = 1) uniform Object {
+	vec4 u_Rect;	// x, y, width, height
+	vec4 u_Colour;
+};
+
+void main()
+{
+	gl_Position = vec4(u_Rect.xy + position.xy * u_Rect.zw, 0.0, 1.0);
+};
+
+
+#shader fragment
+#version 420 core
+
+layout(std140, binding = 1) uniform Object {
+	vec4 u_Rect;
+	vec4 u_Colour;
+};
+
+out vec4 colour;
+
+void main()
+{
+	colour = u_Colour;
+};
@@ -0,0 +1,23 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+
+uniform vec4 u_Rect;	// x, y, width, height
+
+void main()
+{
+	gl_Position = vec4(u_Rect.xy + position.xy * u_Rect.zw, 0.0, 1.0);
+};
+
+
+#shader fragment
+#version 330 core
+
+out vec4 colour;
+uniform vec4 u_Colour;
+
+void main()
+{
+	colour = u_Colour;
+};
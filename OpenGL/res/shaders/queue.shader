@@ -0,0 +1,35 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec2 position;		// in the unit square
+
+uniform vec4 u_Rect;	// x, y, width, height
+
+out vec2 v_TexCoord;
+
+void main()
+{
+	gl_Position = vec4(u_Rect.xy + position * u_Rect.zw, 0.0, 1.0);
+	v_TexCoord = position;
+};
+
+
+#shader fragment
+#version 330 core
+
+uniform vec4 u_Colour;
+#ifdef TEXTURED
+uniform sampler2D u_Texture;	// unit 0
+#endif
+
+in vec2 v_TexCoord;
+out vec4 colour;
+
+void main()
+{
+#ifdef TEXTURED
+	colour = u_Colour * texture(u_Texture, v_TexCoord);
+#else
+	colour = u_Colour;
+#endif
+};
@@ -0,0 +1,45 @@
+#shader vertex
+#version 330 core
+
+// positions may be quantized: position.xyz * u_Scale + u_Offset gets them back (1 and 0 for floats)
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec4 normal;
+layout(location = 2) in vec2 texCoord;
+
+uniform vec3 u_Scale;
+uniform vec3 u_Offset;
+uniform vec4 u_Placement;	// x, y, radius, angle round the y axis
+
+out vec3 v_Normal;
+out vec2 v_TexCoord;
+
+vec3 Rotate(vec3 v)
+{
+	float c = cos(u_Placement.w), s = sin(u_Placement.w);
+	return vec3(c * v.x + s * v.z, v.y, c * v.z - s * v.x);
+}
+
+void main()
+{
+	vec3 p = Rotate(position.xyz * u_Scale + u_Offset);
+	gl_Position = vec4(u_Placement.xy + p.xy * u_Placement.z * vec2(0.75, 1.0), -p.z * 0.5, 1.0);
+	v_Normal = Rotate(normal.xyz);
+	v_TexCoord = texCoord;
+};
+
+
+#shader fragment
+#version 330 core
+
+in vec3 v_Normal;
+in vec2 v_TexCoord;
+
+out vec4 colour;
+
+void main()
+{
+	vec2 cell = floor(v_TexCoord * vec2(32.0, 16.0));
+	vec3 albedo = mod(cell.x + cell.y, 2.0) < 1.0 ? vec3(0.9, 0.6, 0.2) : vec3(0.2, 0.4, 0.8);
+	float diffuse = max(dot(normalize(v_Normal), normalize(vec3(0.4, 0.6, 0.7))), 0.0);
+	colour = vec4(albedo * (0.2 + 0.8 * diffuse), 1.0);
+};
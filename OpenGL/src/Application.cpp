@@ -1,139 +1,89 @@
 #include <GL/glew.h>
-#include <GLFW/glfw3.h>	// would use EGL with OpenGLES?
 //#include <assert.h>
 #include <iostream>
-#include <fstream>
 #include <string>
-#include <sstream>
-#include "renderer.h"
+#include <cstdlib>
+#include <memory>
+#include "Renderer.h"
 #include "VertexBuffer.h"
 #include "IndexBuffer.h"
 #include "VertexArray.h"
 #include "VertexBufferLayout.h"
-
-
-struct ShaderProgramSource {
-	std::string VertexSource;
-	std::string FragmentSource;
-};
-
-static ShaderProgramSource ParseShader(const std::string& filepath)
+#include "ShaderCache.h"
+#include "ShaderCompiler.h"
+#include "ShaderPreprocessor.h"
+#include "Shader.h"
+#include "ShaderWatcher.h"
+#include "GLStateCache.h"
+#include "GLDebug.h"
+#include "GLContext.h"
+#include "Benchmarks.h"
+
+
+int main(int argc, char** argv)
 {
-	std::ifstream stream(filepath);
-
-	enum class ShaderType {
-		NONE = -1,
-		VERTEX = 0,
-		FRAGMENT = 1,
-	};
-
-	ShaderType type = ShaderType::NONE;
-
-	std::string line;
-	std::stringstream ss[2];
-
-	while (getline(stream, line)) {
-		if (line.find("#shader") != std::string::npos) {
-			if (line.find("vertex") != std::string::npos) {
-				// set mode to vertex
-				type = ShaderType::VERTEX;
-			}
-			else if (line.find("fragment") != std::string::npos) {
-				// set mode to fragment
-				type = ShaderType::FRAGMENT;
-			}
-		}
-		else if (ShaderType::NONE != type) {
-			ss[(int)type] << line << '\n';
-		}
-	}
-
-	return{ ss[0].str(), ss[1].str() };
-}
-
-static unsigned int CompileShader(unsigned int type, const std::string& source) {
-
-	unsigned int id = glCreateShader(type);
-	const char* src = source.c_str();
-	glShaderSource(id, 1, &src, nullptr);
-	glCompileShader(id);
-
-	int result;
-	glGetShaderiv(id, GL_COMPILE_STATUS, &result);		//"iv" --> integer vector
-
-	if (GL_FALSE == result) {
-		int len;
-
-		glGetShaderiv(id, GL_INFO_LOG_LENGTH, &len);
-		char *errormsg = (char *)alloca(len * sizeof(char));
-
-		glGetShaderInfoLog(id, len, &len, errormsg);
-
-		std::cout << "Error compiling " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment") << " shader" << errormsg << std::endl;
-
-		glDeleteShader(id);
-		return 0;
+	/* microbenchmarks don't need a window */
+	if (argc > 1 && std::string(argv[1]) == "--bench-parser")
+		return RunParserBenchmark(argc > 2 ? argv[2] : nullptr, argc > 3 ? atoi(argv[3]) : 1000);
+	if (argc > 1 && std::string(argv[1]) == "--bench-mesh")
+		return RunMeshBenchmark(argc > 2 ? atoi(argv[2]) : 256, argc > 3 ? atoi(argv[3]) : 10);
+	if (argc > 1 && std::string(argv[1]) == "--test-mesh")
+		return RunMeshTests(argc > 2 ? atoi(argv[2]) : 32);
+	if (argc > 1 && std::string(argv[1]) == "--bench-sort")
+		return RunSortBenchmark(argc > 2 ? atoi(argv[2]) : 100000, argc > 3 ? atoi(argv[3]) : 100);
+
+	/* --headless renders offscreen (for machines without a display), --frames stops after that many frames and
+	   --output saves the last one. --bench <scene> runs a frame benchmark instead (--frames measured frames after
+	   --warmup ones), writing JSON to --json or stdout and failing if it's --tolerance percent slower than --baseline */
+	bool headless = false;
+	int maxFrames = 0;
+	std::string output;
+	std::string benchScene, benchJson, benchBaseline;
+	int warmupFrames = 100;
+	double tolerance = 10.0;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--headless")
+			headless = true;
+		else if (arg == "--frames" && i + 1 < argc)
+			maxFrames = atoi(argv[++i]);
+		else if (arg == "--output" && i + 1 < argc)
+			output = argv[++i];
+		else if (arg == "--bench" && i + 1 < argc)
+			benchScene = argv[++i];
+		else if (arg == "--warmup" && i + 1 < argc)
+			warmupFrames = atoi(argv[++i]);
+		else if (arg == "--json" && i + 1 < argc)
+			benchJson = argv[++i];
+		else if (arg == "--baseline" && i + 1 < argc)
+			benchBaseline = argv[++i];
+		else if (arg == "--tolerance" && i + 1 < argc)
+			tolerance = atof(argv[++i]);
+		else
+			std::cout << "Unknown argument " << arg << std::endl;
 	}
+	if ((headless || !benchScene.empty()) && 0 == maxFrames)
+		maxFrames = 1000;	// nobody is going to close it
 
-	return id;
-}
-
-static unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader) {
-	unsigned int program = glCreateProgram();
-	unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader);
-	unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
-
-	glAttachShader(program, vs);
-	glAttachShader(program, fs);
-	glLinkProgram(program);
-	glValidateProgram(program);
-
-	glDeleteShader(vs);
-	glDeleteShader(fs);
-
-	return program;
-}
-
-
-int main(void)
-{
-	GLFWwindow* window;
 	float red = 0.0f;
 	float green = 0.0f;
 	float blue = 0.0f;
 	float alpha = 0.0f;
 	float increment = 0.0001f;
 
-	/* Initialize the library */
-	if (!glfwInit())
-		return -1;
-
-	/* Explicitly ask for the compatibility profile for OpenGL Context - this is the default anyway */
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-	/* Create a windowed mode window and its OpenGL context */
-	window = glfwCreateWindow(640, 480, "Hello World", NULL, NULL);	// creates a window AND it's openGL context
-	if (!window)
-	{
-		ASSERT(false);
-		glfwTerminate();
+	std::unique_ptr<GLContext> context = GLContext::Create(headless, 640, 480, "Hello World");
+	if (!context)
 		return -1;
-	}
 
-	/* Make the window's context current */
-	glfwMakeContextCurrent(window);
+#ifdef _DEBUG
+	GLDebug::Enable();	// GL errors come from the debug callback now, GLCall stops polling glGetError
+#endif
 
-	std::cout << glGetString(GL_VERSION) << std::endl;
-
-	if (glewInit() != GLEW_OK) {
-		std::cout << "GLEW Error!" << std::endl;
-		return -1;
-	}
+	if (!benchScene.empty())
+		return RunFrameBenchmark(*context, benchScene, warmupFrames, maxFrames, benchJson, benchBaseline, tolerance);
 
-	{	// we're creating a scope here so that the vb and ib which we create on the stack are destroyed before we call glfwTerminate 
-		// if we don't enclose them in a scope then they don't get destroyed until after glfwTerminate, at which point there's no 
+	{	// we're creating a scope here so that the vb and ib which we create on the stack are destroyed before the context
+		// if we don't enclose them in a scope then they don't get destroyed until after the context is gone, at which point there's no 
 		// glcontext and glCheckError will return an error if there is no valid opengl context, since we call glCheckError in a loop 
 		// the program would never terminate
 	float positions[] = {
@@ -143,16 +93,16 @@ int main(void)
 		-0.5f,  0.5f,		// 3	
 	};
 
-	unsigned int indices[] = {		// could use char / unsigned short, BUT it MUST be an unsigned type
+	unsigned int indices[] = {		// MUST be an unsigned type, IndexBuffer stores them as unsigned short since they're small
 		0, 1, 2,
 		2, 3, 0
 	};
 
-	// create vertex array:
-	unsigned int vao;
-	GLCall(glGenVertexArrays(1, &vao));
-	GLCall(glBindVertexArray(vao));
+#ifdef _DEBUG
+	GLStateCache::Get().SetValidation(true);	// check the binds the state cache skips really were redundant
+#endif
 
+	// create vertex array:
 	VertexArray va;
 
 	// create vertex buffer:
@@ -164,41 +114,40 @@ int main(void)
 
 	// create index buffer:
 	IndexBuffer ib(indices, 6);
-
-	// create shader:
-	ShaderProgramSource source = ParseShader("res/shaders/basic.shader");
-	unsigned int shader = CreateShader(source.VertexSource, source.FragmentSource);
-	GLCall(glUseProgram(shader));
-
-	// set up the uniform (variable) used by the shader
-	GLCall(int location = glGetUniformLocation(shader, "u_Colour"));
-	ASSERT(location != -1);	// note -1 means the uniform isn't used in the program, we can assert because we know it is
-	GLCall(glUniform4f(location, 0.2f, 0.3f, 0.8f, 1.0f));
-
-	/* unbind everything - we're doing this to make clear the steps needed each time we do a draw below */
-	GLCall(glBindVertexArray(0));
-	GLCall(glUseProgram(0));
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
-
-	/* Loop until the user closes the window */
-	while (!glfwWindowShouldClose(window))
+	va.SetIndexBuffer(ib);
+
+	// create shader - compiled on first use, it becomes usable once the compiler reports it ready:
+	ShaderCache shaderCache("shadercache");
+	ShaderCompiler shaderCompiler(&shaderCache);
+	ShaderPreprocessor shaderPreprocessor;
+	Shader shader("res/shaders/basic.shader", {}, shaderPreprocessor, shaderCompiler);
+	static constexpr UniformName u_Colour("u_Colour");	// hashed at compile time
+	ShaderWatcher shaderWatcher;	// edit basic.shader while this runs and it's reloaded
+	shaderWatcher.Watch(shader);
+	unsigned int elidedUniforms = 0;
+	Renderer renderer;
+
+	/* nothing to unbind: creating the buffers and describing the vertex array didn't bind anything with direct state
+	   access (and the draw below binds what it needs either way) */
+
+	/* Loop until the user closes the window (or we reach --frames) */
+	for (int frame = 0; !context->ShouldClose() && (0 == maxFrames || frame < maxFrames); frame++)
 	{
 		/* Render here */
-		glClear(GL_COLOR_BUFFER_BIT);
-
-		/* Do necessary binding before we draw */
-		// bind shader:
-		GLCall(glUseProgram(shader));
-		GLCall(glUniform4f(location, red, green, blue, 1.0f));
-
-		// bind va
-		va.Bind();
-		// bind index buffer
-		ib.Bind();
-
-		// draw
-		GLCall(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr));	// can use nullptr because index buffer already bound
+		renderer.Clear();
+
+		/* pick up edited shaders, then do necessary binding before we draw - skipped while the shader is still compiling */
+		shaderWatcher.Update();
+		shaderCompiler.Poll();
+		shader.Update();
+		if (shader.Bind(0)) {
+			// set the uniform (variable) used by the shader - skipped by the shader if the colour didn't change
+			shader.SetUniform(u_Colour, red, green, blue, 1.0f);
+
+			// bind va and index buffer, then draw - after the first frame the state cache skips the binds, nothing else
+			// changes them
+			renderer.Draw(va, ib, shader);
+		}
 
 		if (red < 1.0)
 			red += increment;
@@ -209,16 +158,23 @@ int main(void)
 
 
 		/* Swap front and back buffers */
-		GLCall(glfwSwapBuffers(window));
+		context->SwapBuffers();
 
 		/* Poll for and process events */
-		GLCall(glfwPollEvents());
+		context->PollEvents();
+
+		elidedUniforms += UniformTable::GetFrameStats().elided;
+		UniformTable::ResetFrameStats();
 	}
 
-	GLCall(glDeleteProgram(shader));
+	shaderCache.PrintStats();
+	std::cout << "Uniform uploads elided: " << elidedUniforms << std::endl;
+	std::cout << "State changes issued: " << GLStateCache::Get().GetStats().issued << ", elided: " << GLStateCache::Get().GetStats().elided << std::endl;
+
+	if (!output.empty())
+		context->SaveFrame(output);
 
 	}
-	glfwTerminate();
 	return 0;
 }
 
@@ -0,0 +1,129 @@
+#include "BatchRenderer.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <string>
+
+BatchRenderer::BatchRenderer(unsigned int maxQuads, ShaderPreprocessor & preprocessor, ShaderCompiler & compiler)
+	: m_MaxQuads(maxQuads), m_MaxTextures(QueryMaxTextures()),
+	m_VertexBuffer(maxQuads * 4 * sizeof(Vertex)), m_IndexBuffer(GenerateIndices(maxQuads).data(), maxQuads * 6),
+	m_Shader("res/shaders/batch.shader", {}, preprocessor, compiler, { { "MAX_TEXTURES", std::to_string(m_MaxTextures) } }),
+	m_Staging(maxQuads * 4), m_Head(m_Staging.data()), m_LastTexture(0), m_LastSlot(0)
+{
+	static constexpr auto layout = MakeVertexLayout<Vertex>(VERTEX_ATTRIBUTE(Vertex, position), VERTEX_ATTRIBUTE(Vertex, texCoord),
+		VERTEX_ATTRIBUTE(Vertex, colour), VERTEX_ATTRIBUTE_INTEGER(Vertex, texIndex));
+	static_assert(layout.IsValid() && layout.stride == 9 * sizeof(float), "BatchRenderer::Vertex layout");
+	m_VertexArray.AddBuffer(m_VertexBuffer, layout);
+	m_VertexArray.SetIndexBuffer(m_IndexBuffer);
+
+	const unsigned int white = 0xFFFFFFFF;
+	GLCall(glGenTextures(1, &m_WhiteTexture));
+	GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, m_WhiteTexture);
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &white));
+	m_Textures.push_back(m_WhiteTexture);
+
+	m_Stats.draws = 0;
+	m_Stats.quads = 0;
+}
+
+BatchRenderer::~BatchRenderer()
+{
+	GLStateCache::Get().DeleteTexture(m_WhiteTexture);
+}
+
+unsigned int BatchRenderer::QueryMaxTextures()
+{
+	int units;
+	GLCall(glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &units));
+	return std::min((unsigned int)units, GLStateCache::MaxTextureUnits);
+}
+
+std::vector<unsigned int> BatchRenderer::GenerateIndices(unsigned int maxQuads)
+{
+	// every quad is 0, 1, 2, 2, 3, 0 from its first vertex
+	std::vector<unsigned int> indices(maxQuads * 6);
+	for (unsigned int quad = 0, vertex = 0; quad < maxQuads; quad++, vertex += 4) {
+		unsigned int* index = &indices[quad * 6];
+		index[0] = vertex;
+		index[1] = vertex + 1;
+		index[2] = vertex + 2;
+		index[3] = vertex + 2;
+		index[4] = vertex + 3;
+		index[5] = vertex;
+	}
+	return indices;
+}
+
+unsigned int BatchRenderer::GetSlot(unsigned int texture)
+{
+	if (0 == texture)
+		return 0;
+	if (texture == m_LastTexture)
+		return m_LastSlot;
+
+	auto it = std::find(m_Textures.begin(), m_Textures.end(), texture);
+	if (it == m_Textures.end()) {
+		if (m_Textures.size() == m_MaxTextures)
+			Flush();
+		m_Textures.push_back(texture);
+		it = m_Textures.end() - 1;
+	}
+
+	m_LastTexture = texture;
+	m_LastSlot = (unsigned int)(it - m_Textures.begin());
+	return m_LastSlot;
+}
+
+void BatchRenderer::Begin()
+{
+	m_Head = m_Staging.data();
+	m_Textures.resize(1);
+	m_LastTexture = 0;
+}
+
+void BatchRenderer::DrawQuad(float x, float y, float width, float height, const float * colour)
+{
+	DrawQuad(x, y, width, height, 0, colour);
+}
+
+void BatchRenderer::DrawQuad(float x, float y, float width, float height, unsigned int texture, const float * colour)
+{
+	if (m_Head == m_Staging.data() + m_Staging.size())
+		Flush();
+	unsigned int slot = GetSlot(texture);
+
+	Vertex* vertex = m_Head;
+	vertex[0] = { { x, y }, { 0.0f, 0.0f }, { colour[0], colour[1], colour[2], colour[3] }, slot };
+	vertex[1] = { { x + width, y }, { 1.0f, 0.0f }, { colour[0], colour[1], colour[2], colour[3] }, slot };
+	vertex[2] = { { x + width, y + height }, { 1.0f, 1.0f }, { colour[0], colour[1], colour[2], colour[3] }, slot };
+	vertex[3] = { { x, y + height }, { 0.0f, 1.0f }, { colour[0], colour[1], colour[2], colour[3] }, slot };
+	m_Head += 4;
+}
+
+void BatchRenderer::Flush()
+{
+	unsigned int quads = (unsigned int)(m_Head - m_Staging.data()) / 4;
+	if (quads && m_Shader.Bind(0)) {
+		m_VertexBuffer.SetData(m_Staging.data(), quads * 4 * sizeof(Vertex));
+		for (unsigned int slot = 0; slot < m_Textures.size(); slot++)
+			GLStateCache::Get().BindTexture(slot, GL_TEXTURE_2D, m_Textures[slot]);
+
+		m_VertexArray.Bind();
+		m_IndexBuffer.Bind();
+		GLCall(glDrawElements(GL_TRIANGLES, quads * 6, m_IndexBuffer.GetType(), nullptr));
+		m_Stats.draws++;
+		m_Stats.quads += quads;
+	}
+
+	// the next batch starts over with just the white texture
+	m_Head = m_Staging.data();
+	m_Textures.resize(1);
+	m_LastTexture = 0;
+}
+
+void BatchRenderer::End()
+{
+	Flush();
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+
+// draws lots of quads with few draw calls. Quads are written into a CPU staging array and sent with one buffer upload
+// and one glDrawElements per batch; the index buffer is generated once for the largest batch. A batch holds up to
+// maxQuads quads and as many textures as there are texture units (slot 0 is a white texture for untextured quads),
+// it's flushed early when either runs out.
+//   Begin() -> DrawQuad() ... -> End()
+class BatchRenderer
+{
+public:
+	struct Vertex {
+		float position[2];
+		float texCoord[2];
+		float colour[4];
+		unsigned int texIndex;	// texture slot, an integer attribute (a uint in the shader)
+	};
+
+	struct Stats {
+		unsigned int draws;		// batches flushed
+		unsigned int quads;
+	};
+
+private:
+	unsigned int m_MaxQuads;
+	unsigned int m_MaxTextures;				// GL_MAX_TEXTURE_IMAGE_UNITS, capped by the state cache
+	VertexArray m_VertexArray;
+	VertexBuffer m_VertexBuffer;
+	IndexBuffer m_IndexBuffer;
+	Shader m_Shader;
+	unsigned int m_WhiteTexture;
+
+	std::vector<Vertex> m_Staging;
+	Vertex* m_Head;							// next free vertex in m_Staging
+	std::vector<unsigned int> m_Textures;	// bound to slot i for this batch
+	unsigned int m_LastTexture;				// the last lookup, most quads use the same texture as the one before
+	unsigned int m_LastSlot;
+	Stats m_Stats;
+
+	static unsigned int QueryMaxTextures();
+
+	/* slot of texture in this batch, flushes first if the batch is out of slots */
+	unsigned int GetSlot(unsigned int texture);
+
+public:
+	BatchRenderer(unsigned int maxQuads, ShaderPreprocessor& preprocessor, ShaderCompiler& compiler);
+	~BatchRenderer();
+
+	void Begin();
+	/* x, y is the bottom left corner, in clip space. colour is RGBA */
+	void DrawQuad(float x, float y, float width, float height, const float* colour);
+	/* texture 0 draws untextured, colour tints the texture */
+	void DrawQuad(float x, float y, float width, float height, unsigned int texture, const float* colour);
+	/* draws what has been collected so far */
+	void Flush();
+	void End();
+
+	/* 0, 1, 2, 2, 3, 0 for each quad's four vertices */
+	static std::vector<unsigned int> GenerateIndices(unsigned int maxQuads);
+
+	/* the shader compiles in the background, batches flushed before it's ready aren't drawn */
+	inline bool IsReady() { return m_Shader.GetProgram(0) != 0; }
+	inline unsigned int GetMaxTextures() const { return m_MaxTextures; }
+	inline const Stats& GetStats() const { return m_Stats; }
+	inline void ResetStats() { m_Stats.draws = 0; m_Stats.quads = 0; }
+};
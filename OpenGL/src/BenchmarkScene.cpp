@@ -0,0 +1,1293 @@
+#include "BenchmarkScene.h"
+#include "Renderer.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "VertexArray.h"
+#include "VertexBufferLayout.h"
+#include "ShaderCompiler.h"
+#include "ShaderPreprocessor.h"
+#include "Shader.h"
+#include "UniformTable.h"
+#include "BatchRenderer.h"
+#include "GLStateCache.h"
+#include "MeshPool.h"
+#include "IndirectBuffer.h"
+#include "StreamingVertexBuffer.h"
+#include "MeshOptimizer.h"
+#include "VertexEncoder.h"
+#include "UniformBuffer.h"
+#include "RenderQueue.h"
+#include "ParallelRecorder.h"
+#include "BufferArena.h"
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace {
+
+	// what Application.cpp draws: one quad, one uniform, one glDrawElements
+	class QuadScene : public BenchmarkScene
+	{
+	private:
+		VertexArray m_VertexArray;
+		VertexBuffer m_VertexBuffer;
+		IndexBuffer m_IndexBuffer;
+		ShaderCompiler m_Compiler;
+		ShaderPreprocessor m_Preprocessor;
+		Shader m_Shader;
+		float m_Red;
+
+		static const float Positions[8];
+
+	public:
+		static const unsigned int Indices[6];
+
+		QuadScene()
+			: m_VertexBuffer(Positions, sizeof(Positions)), m_IndexBuffer(Indices, 6), m_Compiler(nullptr),
+			m_Shader("res/shaders/basic.shader", {}, m_Preprocessor, m_Compiler), m_Red(0.0f)
+		{
+			VertexBufferLayout layout;
+			layout.Push<float>(2);
+			m_VertexArray.AddBuffer(m_VertexBuffer, layout);
+			m_VertexArray.SetIndexBuffer(m_IndexBuffer);
+
+			// compile up front, the benchmark shouldn't measure the shader compiler
+			m_Shader.GetProgram(0);
+			m_Compiler.WaitAll();
+		}
+
+		const char* GetName() const override { return "quad"; }
+
+		void Update(int frame) override
+		{
+			m_Red = (frame % 256) / 255.0f;
+		}
+
+		SceneStats Submit() override
+		{
+			static constexpr UniformName u_Colour("u_Colour");
+
+			SceneStats stats = { 0, 0, 0, 0 };
+			if (!m_Shader.Bind(0))
+				return stats;
+
+			m_Shader.SetUniform(u_Colour, m_Red, 0.3f, 0.8f, 1.0f);
+			m_VertexArray.Bind();
+			m_IndexBuffer.Bind();
+			GLCall(glDrawElements(GL_TRIANGLES, 6, m_IndexBuffer.GetType(), nullptr));
+
+			stats.draws = 1;
+			stats.triangles = 2;
+			return stats;
+		}
+	};
+
+	// a grid of small quads covering the screen, drawn one by one or batched
+	const unsigned int GridColumns = 250;
+	const unsigned int GridRows = 200;
+	const unsigned int GridQuads = GridColumns * GridRows;
+
+	void GetGridQuad(unsigned int index, int frame, float* rect, float* colour)
+	{
+		const float width = 2.0f / GridColumns, height = 2.0f / GridRows;
+		rect[0] = -1.0f + (index % GridColumns) * width;
+		rect[1] = -1.0f + (index / GridColumns) * height;
+		rect[2] = width * 0.8f;
+		rect[3] = height * 0.8f;
+
+		colour[0] = ((index + frame) & 255) / 255.0f;
+		colour[1] = ((index >> 8) & 255) / 255.0f;
+		colour[2] = 0.5f;
+		colour[3] = 1.0f;
+	}
+
+	// the grid the way Application.cpp would draw it: a uniform upload and a glDrawElements per quad
+	class QuadsScene : public BenchmarkScene
+	{
+	private:
+		VertexArray m_VertexArray;
+		VertexBuffer m_VertexBuffer;
+		IndexBuffer m_IndexBuffer;
+		ShaderCompiler m_Compiler;
+		ShaderPreprocessor m_Preprocessor;
+		Shader m_Shader;
+		int m_Frame;
+
+	public:
+		static const float Positions[8];
+
+		QuadsScene()
+			: m_VertexBuffer(Positions, sizeof(Positions)), m_IndexBuffer(QuadScene::Indices, 6), m_Compiler(nullptr),
+			m_Shader("res/shaders/quad.shader", {}, m_Preprocessor, m_Compiler), m_Frame(0)
+		{
+			VertexBufferLayout layout;
+			layout.Push<float>(2);
+			m_VertexArray.AddBuffer(m_VertexBuffer, layout);
+			m_VertexArray.SetIndexBuffer(m_IndexBuffer);
+
+			m_Shader.GetProgram(0);
+			m_Compiler.WaitAll();
+		}
+
+		const char* GetName() const override { return "quads"; }
+
+		void Update(int frame) override
+		{
+			m_Frame = frame;
+		}
+
+		SceneStats Submit() override
+		{
+			static constexpr UniformName u_Rect("u_Rect");
+			static constexpr UniformName u_Colour("u_Colour");
+
+			SceneStats stats = { 0, 0, 0, 0 };
+			for (unsigned int i = 0; i < GridQuads; i++) {
+				if (!m_Shader.Bind(0))
+					break;
+
+				float rect[4], colour[4];
+				GetGridQuad(i, m_Frame, rect, colour);
+				m_Shader.SetUniform(u_Rect, rect[0], rect[1], rect[2], rect[3]);
+				m_Shader.SetUniform(u_Colour, colour[0], colour[1], colour[2], colour[3]);
+				m_VertexArray.Bind();
+				m_IndexBuffer.Bind();
+				GLCall(glDrawElements(GL_TRIANGLES, 6, m_IndexBuffer.GetType(), nullptr));
+
+				stats.draws++;
+				stats.triangles += 2;
+			}
+			return stats;
+		}
+	};
+
+	const float QuadsScene::Positions[8] = {
+		0.0f, 0.0f,
+		1.0f, 0.0f,
+		1.0f, 1.0f,
+		0.0f, 1.0f,
+	};
+
+	// the grid again with each quad's rect and colour in a std140 block of a UniformBuffer instead of two glUniform
+	// calls: the frame's blocks go up in one upload (none at all when the buffer is persistently mapped), then every
+	// draw binds its range. Sub data forces the glBufferSubData path. Should look exactly like quads
+	class UniformsScene : public BenchmarkScene
+	{
+	private:
+		typedef Std140Layout<std140::Vec4, std140::Vec4> ObjectBlock;		// rect, colour
+		static const unsigned int ObjectBinding = 1;
+
+		VertexArray m_VertexArray;
+		VertexBuffer m_VertexBuffer;
+		IndexBuffer m_IndexBuffer;
+		ShaderCompiler m_Compiler;
+		ShaderPreprocessor m_Preprocessor;
+		Shader m_Shader;
+		UniformBuffer m_UniformBuffer;
+		std::vector<UniformBuffer::Allocation> m_Blocks;
+		int m_Frame;
+
+	public:
+		UniformsScene(bool subData)
+			: m_VertexBuffer(QuadsScene::Positions, sizeof(QuadsScene::Positions)), m_IndexBuffer(QuadScene::Indices, 6),
+			m_Compiler(nullptr), m_Shader("res/shaders/quad-block.shader", {}, m_Preprocessor, m_Compiler),
+			m_UniformBuffer(GridQuads * std140::AlignUp(ObjectBlock::Size, UniformBuffer::QueryAlignment()), !subData), m_Blocks(GridQuads), m_Frame(0)
+		{
+			VertexBufferLayout layout;
+			layout.Push<float>(2);
+			m_VertexArray.AddBuffer(m_VertexBuffer, layout);
+			m_VertexArray.SetIndexBuffer(m_IndexBuffer);
+
+			m_Shader.GetProgram(0);
+			m_Compiler.WaitAll();
+		}
+
+		const char* GetName() const override { return m_UniformBuffer.IsPersistent() ? "quads-ubo" : "quads-ubo-subdata"; }
+
+		void Update(int frame) override
+		{
+			m_Frame = frame;
+		}
+
+		SceneStats Submit() override
+		{
+			SceneStats stats = { 0, 0, 0, 0 };
+			if (!m_Shader.Bind(0))
+				return stats;
+
+			m_UniformBuffer.ResetStats();
+			m_UniformBuffer.BeginFrame();
+			unsigned int count = 0;		// quads that got a block, the rest are skipped if the buffer is full
+			for (; count < GridQuads; count++) {
+				m_Blocks[count] = m_UniformBuffer.Allocate<ObjectBlock>();
+				if (!m_Blocks[count].data)
+					break;
+				float rect[4], colour[4];
+				GetGridQuad(count, m_Frame, rect, colour);
+				ObjectBlock::Write<0>(m_Blocks[count].data, rect);
+				ObjectBlock::Write<1>(m_Blocks[count].data, colour);
+			}
+			m_UniformBuffer.Upload();
+			stats.uploaded = m_UniformBuffer.GetUsed();
+
+			m_VertexArray.Bind();
+			for (unsigned int i = 0; i < count; i++) {
+				m_UniformBuffer.Bind(ObjectBinding, m_Blocks[i]);
+				GLCall(glDrawElements(GL_TRIANGLES, 6, m_IndexBuffer.GetType(), nullptr));
+			}
+			m_UniformBuffer.EndFrame();
+
+			stats.draws = count;
+			stats.triangles = count * 2ull;
+			stats.stalls = m_UniformBuffer.GetStats().stalls;
+			return stats;
+		}
+	};
+
+	// the same grid through the BatchRenderer. Textured cycles through a few textures, a different one every quad
+	class BatchScene : public BenchmarkScene
+	{
+	private:
+		ShaderCompiler m_Compiler;
+		ShaderPreprocessor m_Preprocessor;
+		BatchRenderer m_Renderer;
+		std::vector<unsigned int> m_Textures;
+		int m_Frame;
+
+	public:
+		BatchScene(bool textured)
+			: m_Compiler(nullptr), m_Renderer(10000, m_Preprocessor, m_Compiler), m_Frame(0)
+		{
+			for (unsigned int i = 0; textured && i < 8; i++) {
+				unsigned int texture;
+				unsigned int texels[4] = { 0xFFFFFFFF, 0xFF000000u | (i * 0x1F3F5F), 0xFF000000u | (i * 0x1F3F5F), 0xFFFFFFFF };
+				GLCall(glGenTextures(1, &texture));
+				GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, texture);
+				GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+				GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+				GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels));
+				m_Textures.push_back(texture);
+			}
+
+			m_Renderer.IsReady();
+			m_Compiler.WaitAll();
+		}
+
+		~BatchScene()
+		{
+			for (unsigned int texture : m_Textures)
+				GLStateCache::Get().DeleteTexture(texture);
+		}
+
+		const char* GetName() const override { return m_Textures.empty() ? "batch" : "batch-textured"; }
+
+		void Update(int frame) override
+		{
+			m_Frame = frame;
+		}
+
+		SceneStats Submit() override
+		{
+			m_Renderer.ResetStats();
+			m_Renderer.Begin();
+			for (unsigned int i = 0; i < GridQuads; i++) {
+				float rect[4], colour[4];
+				GetGridQuad(i, m_Frame, rect, colour);
+				unsigned int texture = m_Textures.empty() ? 0 : m_Textures[i % m_Textures.size()];
+				m_Renderer.DrawQuad(rect[0], rect[1], rect[2], rect[3], texture, colour);
+			}
+			m_Renderer.End();
+
+			SceneStats stats = { m_Renderer.GetStats().draws, m_Renderer.GetStats().quads * 2ull,
+				m_Renderer.GetStats().quads * 4ull * sizeof(BatchRenderer::Vertex), 0 };
+			return stats;
+		}
+	};
+
+	// the grid as instances of one quad: a colour and a mat4 transform per instance, one glDrawElementsInstanced
+	class InstancedScene : public BenchmarkScene
+	{
+	private:
+		struct Instance {
+			float colour[4];
+			float transform[16];	// column major
+		};
+
+		VertexArray m_VertexArray;
+		VertexBuffer m_VertexBuffer;
+		VertexBuffer m_InstanceBuffer;
+		IndexBuffer m_IndexBuffer;
+		ShaderCompiler m_Compiler;
+		ShaderPreprocessor m_Preprocessor;
+		Shader m_Shader;
+		Renderer m_Renderer;
+		std::vector<Instance> m_Instances;
+
+	public:
+		InstancedScene()
+			: m_VertexBuffer(QuadsScene::Positions, sizeof(QuadsScene::Positions)), m_InstanceBuffer(GridQuads * sizeof(Instance)),
+			m_IndexBuffer(QuadScene::Indices, 6), m_Compiler(nullptr),
+			m_Shader("res/shaders/instanced.shader", {}, m_Preprocessor, m_Compiler), m_Instances(GridQuads)
+		{
+			VertexBufferLayout layout;
+			layout.Push<float>(2);
+			m_VertexArray.AddBuffer(m_VertexBuffer, layout);
+
+			VertexBufferLayout instanceLayout(1);
+			instanceLayout.Push<float>(4);			// colour
+			instanceLayout.PushMatrix(4, 4);		// transform
+			m_VertexArray.AddBuffer(m_InstanceBuffer, instanceLayout);
+
+			m_Shader.GetProgram(0);
+			m_Compiler.WaitAll();
+		}
+
+		const char* GetName() const override { return "instanced"; }
+
+		void Update(int frame) override
+		{
+			for (unsigned int i = 0; i < GridQuads; i++) {
+				Instance& instance = m_Instances[i];
+				float rect[4];
+				GetGridQuad(i, frame, rect, instance.colour);
+
+				float* m = instance.transform;
+				m[0] = rect[2];	m[4] = 0.0f;	m[8] = 0.0f;	m[12] = rect[0];
+				m[1] = 0.0f;	m[5] = rect[3];	m[9] = 0.0f;	m[13] = rect[1];
+				m[2] = 0.0f;	m[6] = 0.0f;	m[10] = 1.0f;	m[14] = 0.0f;
+				m[3] = 0.0f;	m[7] = 0.0f;	m[11] = 0.0f;	m[15] = 1.0f;
+			}
+		}
+
+		SceneStats Submit() override
+		{
+			m_InstanceBuffer.SetData(m_Instances.data(), GridQuads * sizeof(Instance));
+
+			SceneStats stats = { 0, 0, 0, 0 };
+			if (m_Renderer.DrawInstanced(m_VertexArray, m_IndexBuffer, m_Shader, GridQuads)) {
+				stats.draws = 1;
+				stats.triangles = GridQuads * 2ull;
+				stats.uploaded = GridQuads * sizeof(Instance);
+			}
+			return stats;
+		}
+	};
+
+	// a fan round the centre of the unit square, x, y per vertex
+	void GeneratePolygon(unsigned int sides, std::vector<float>& vertices, std::vector<unsigned int>& indices)
+	{
+		vertices = { 0.5f, 0.5f };
+		indices.clear();
+		for (unsigned int side = 0; side < sides; side++) {
+			float angle = side * 6.2831853f / sides;
+			vertices.push_back(0.5f + 0.5f * std::cos(angle));
+			vertices.push_back(0.5f + 0.5f * std::sin(angle));
+			indices.push_back(0);
+			indices.push_back(1 + side);
+			indices.push_back(1 + (side + 1) % sides);
+		}
+	}
+
+	// the grid again, every cell a different mesh (polygons of 3 to 34 sides) with its own rect and colour. All meshes
+	// share one MeshPool; drawn with a glDrawElementsInstancedBaseVertexBaseInstance per object or, indirect, with one
+	// glMultiDrawElementsIndirect from commands uploaded once
+	class MeshesScene : public BenchmarkScene
+	{
+	private:
+		struct DrawData {
+			float rect[4];
+			float colour[4];
+		};
+
+		static const unsigned int MeshCount = 32;
+
+		ShaderCompiler m_Compiler;
+		ShaderPreprocessor m_Preprocessor;
+		Shader m_Shader;
+		MeshPool m_Pool;
+		VertexBuffer m_DrawBuffer;
+		IndirectBuffer m_Commands;
+		Renderer m_Renderer;
+		Mesh m_Meshes[MeshCount];
+		std::vector<DrawData> m_DrawData;
+		bool m_Indirect;
+
+		static VertexBufferLayout PositionLayout()
+		{
+			VertexBufferLayout layout;
+			layout.Push<float>(2);
+			return layout;
+		}
+
+	public:
+		MeshesScene(bool indirect)
+			: m_Compiler(nullptr), m_Shader("res/shaders/meshes.shader", {}, m_Preprocessor, m_Compiler),
+			m_Pool(PositionLayout(), MeshCount * 40, MeshCount * 40 * 3), m_DrawBuffer(GridQuads * sizeof(DrawData)),
+			m_Commands(GridQuads), m_DrawData(GridQuads), m_Indirect(indirect)
+		{
+			VertexBufferLayout drawLayout(1);
+			drawLayout.Push<float>(4);		// rect
+			drawLayout.Push<float>(4);		// colour
+			m_Pool.AddDrawData(m_DrawBuffer, drawLayout);
+
+			for (unsigned int i = 0; i < MeshCount; i++) {
+				std::vector<float> vertices;
+				std::vector<unsigned int> indices;
+				GeneratePolygon(3 + i, vertices, indices);
+				m_Pool.Add(vertices.data(), 4 + i, indices.data(), (unsigned int)indices.size(), m_Meshes[i]);
+			}
+
+			// the object -> mesh assignment never changes, so neither do the commands
+			for (unsigned int i = 0; i < GridQuads; i++)
+				m_Commands.Add(m_Meshes[i % MeshCount]);
+			m_Commands.Upload();
+
+			m_Shader.GetProgram(0);
+			m_Compiler.WaitAll();
+		}
+
+		const char* GetName() const override { return m_Indirect ? "meshes-indirect" : "meshes"; }
+
+		void Update(int frame) override
+		{
+			for (unsigned int i = 0; i < GridQuads; i++)
+				GetGridQuad(i, frame, m_DrawData[i].rect, m_DrawData[i].colour);
+		}
+
+		SceneStats Submit() override
+		{
+			m_DrawBuffer.SetData(m_DrawData.data(), GridQuads * sizeof(DrawData));
+
+			SceneStats stats = { 0, 0, GridQuads * sizeof(DrawData), 0 };
+			if (m_Indirect) {
+				if (!m_Renderer.DrawIndirect(m_Pool.GetVertexArray(), m_Pool.GetIndexBuffer(), m_Commands, m_Shader))
+					return stats;
+				stats.draws = 1;
+			}
+			else {
+				if (!m_Shader.Bind(0))
+					return stats;
+				m_Pool.GetVertexArray().Bind();
+				const IndexBuffer& indices = m_Pool.GetIndexBuffer();
+				for (const DrawElementsIndirectCommand& command : m_Commands.GetCommands()) {
+					GLCall(glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, command.count, indices.GetType(),
+						(const void*)(size_t)(command.firstIndex * indices.GetIndexSize()), command.instanceCount, command.baseVertex, command.baseInstance));
+				}
+				stats.draws = GridQuads;
+			}
+
+			for (const DrawElementsIndirectCommand& command : m_Commands.GetCommands())
+				stats.triangles += command.count / 3;
+			return stats;
+		}
+	};
+
+	// the polygons again, each in its own vertex and index buffer, drawn one by one with uniforms like quads (every draw
+	// switches mesh). Either every mesh has its own vertex array, or, shared, there's one for the format and the
+	// buffers are swapped in with SetVertexBuffer / SetIndexBuffer
+	class BuffersScene : public BenchmarkScene
+	{
+	private:
+		static const unsigned int MeshCount = 32;
+
+		ShaderCompiler m_Compiler;
+		ShaderPreprocessor m_Preprocessor;
+		Shader m_Shader;
+		std::vector<std::unique_ptr<VertexBuffer>> m_VertexBuffers;
+		std::vector<std::unique_ptr<IndexBuffer>> m_IndexBuffers;
+		std::vector<std::unique_ptr<VertexArray>> m_VertexArrays;		// one, or one per mesh
+		bool m_Shared;
+		int m_Frame;
+
+	public:
+		BuffersScene(bool shared)
+			: m_Compiler(nullptr), m_Shader("res/shaders/quad.shader", {}, m_Preprocessor, m_Compiler), m_Shared(shared), m_Frame(0)
+		{
+			VertexBufferLayout layout;
+			layout.Push<float>(2);
+
+			for (unsigned int i = 0; i < MeshCount; i++) {
+				std::vector<float> vertices;
+				std::vector<unsigned int> indices;
+				GeneratePolygon(3 + i, vertices, indices);
+				m_VertexBuffers.emplace_back(new VertexBuffer(vertices.data(), (unsigned int)vertices.size() * sizeof(float)));
+				m_IndexBuffers.emplace_back(new IndexBuffer(indices.data(), (unsigned int)indices.size()));
+
+				if (0 == i || !shared) {
+					m_VertexArrays.emplace_back(new VertexArray());
+					m_VertexArrays.back()->AddBuffer(*m_VertexBuffers[i], layout);
+					m_VertexArrays.back()->SetIndexBuffer(*m_IndexBuffers[i]);
+				}
+			}
+
+			m_Shader.GetProgram(0);
+			m_Compiler.WaitAll();
+		}
+
+		const char* GetName() const override { return m_Shared ? "buffers-shared" : "buffers"; }
+
+		void Update(int frame) override
+		{
+			m_Frame = frame;
+		}
+
+		SceneStats Submit() override
+		{
+			static constexpr UniformName u_Rect("u_Rect");
+			static constexpr UniformName u_Colour("u_Colour");
+
+			SceneStats stats = { 0, 0, 0, 0 };
+			if (!m_Shader.Bind(0))
+				return stats;
+
+			if (m_Shared)
+				m_VertexArrays[0]->Bind();		// once, swapping buffers doesn't need it bound with direct state access
+			for (unsigned int i = 0; i < GridQuads; i++) {
+				const unsigned int mesh = i % MeshCount;
+				const IndexBuffer& indices = *m_IndexBuffers[mesh];
+				if (m_Shared) {
+					m_VertexArrays[0]->SetVertexBuffer(0, *m_VertexBuffers[mesh]);
+					m_VertexArrays[0]->SetIndexBuffer(indices);
+				}
+				else {
+					m_VertexArrays[mesh]->Bind();
+				}
+
+				float rect[4], colour[4];
+				GetGridQuad(i, m_Frame, rect, colour);
+				m_Shader.SetUniform(u_Rect, rect[0], rect[1], rect[2], rect[3]);
+				m_Shader.SetUniform(u_Colour, colour[0], colour[1], colour[2], colour[3]);
+				GLCall(glDrawElements(GL_TRIANGLES, indices.GetCount(), indices.GetType(), nullptr));
+
+				stats.draws++;
+				stats.triangles += indices.GetCount() / 3;
+			}
+			return stats;
+		}
+	};
+
+	// buffers-shared with every mesh a view into one BufferArena of small blocks. Twice as many polygons are loaded as
+	// drawn and every other one is dropped again, which leaves the live ones spread over twice the blocks with holes
+	// between them; defragmented packs them together again before the run. Fewer blocks means fewer element buffer
+	// switches (see state_changes_per_frame). The arena's stats go in the JSON
+	class ArenaScene : public BenchmarkScene
+	{
+	private:
+		static const unsigned int MeshCount = 32;
+		static const unsigned int BlockSize = 4096;		// bytes, small so the polygons need several
+
+		ShaderCompiler m_Compiler;
+		ShaderPreprocessor m_Preprocessor;
+		Shader m_Shader;
+		BufferArena m_Arena;
+		std::vector<std::unique_ptr<VertexBuffer>> m_VertexBuffers;
+		std::vector<std::unique_ptr<IndexBuffer>> m_IndexBuffers;
+		VertexArray m_VertexArray;
+		unsigned int m_Moved;		// allocations Defragment() moved
+		bool m_Defragmented;
+		int m_Frame;
+
+	public:
+		ArenaScene(bool defragment)
+			: m_Compiler(nullptr), m_Shader("res/shaders/quad.shader", {}, m_Preprocessor, m_Compiler), m_Arena(BlockSize),
+			m_Moved(0), m_Defragmented(defragment), m_Frame(0)
+		{
+			VertexBufferLayout layout;
+			layout.Push<float>(2);
+			m_VertexArray.AddFormat(layout);
+
+			for (unsigned int i = 0; i < MeshCount * 2; i++) {
+				std::vector<float> vertices;
+				std::vector<unsigned int> indices;
+				GeneratePolygon(3 + i, vertices, indices);
+				m_VertexBuffers.emplace_back(new VertexBuffer(m_Arena, vertices.data(), (unsigned int)vertices.size() * sizeof(float)));
+				m_IndexBuffers.emplace_back(new IndexBuffer(m_Arena, indices.data(), (unsigned int)indices.size()));
+			}
+			// the views free their allocations
+			for (unsigned int i = 0; i < MeshCount; i++) {
+				m_VertexBuffers.erase(m_VertexBuffers.begin() + i + 1);
+				m_IndexBuffers.erase(m_IndexBuffers.begin() + i + 1);
+			}
+
+			if (defragment)
+				m_Moved = m_Arena.Defragment();
+
+			m_Shader.GetProgram(0);
+			m_Compiler.WaitAll();
+		}
+
+		const char* GetName() const override { return m_Defragmented ? "arena-defragmented" : "arena"; }
+
+		void Update(int frame) override
+		{
+			m_Frame = frame;
+		}
+
+		SceneStats Submit() override
+		{
+			static constexpr UniformName u_Rect("u_Rect");
+			static constexpr UniformName u_Colour("u_Colour");
+
+			SceneStats stats = { 0, 0, 0, 0 };
+			if (!m_Shader.Bind(0))
+				return stats;
+
+			m_VertexArray.Bind();
+			for (unsigned int i = 0; i < GridQuads; i++) {
+				const unsigned int mesh = i % MeshCount;
+				const IndexBuffer& indices = *m_IndexBuffers[mesh];
+				// set every draw anyway, so the offsets are never the ones from before Defragment()
+				m_VertexArray.SetVertexBuffer(0, *m_VertexBuffers[mesh]);
+				m_VertexArray.SetIndexBuffer(indices);
+
+				float rect[4], colour[4];
+				GetGridQuad(i, m_Frame, rect, colour);
+				m_Shader.SetUniform(u_Rect, rect[0], rect[1], rect[2], rect[3]);
+				m_Shader.SetUniform(u_Colour, colour[0], colour[1], colour[2], colour[3]);
+				GLCall(glDrawElements(GL_TRIANGLES, indices.GetCount(), indices.GetType(), (const void*)(size_t)indices.GetOffset()));
+
+				stats.draws++;
+				stats.triangles += indices.GetCount() / 3;
+			}
+			return stats;
+		}
+
+		std::vector<std::pair<std::string, double>> GetCounters() const override
+		{
+			const BufferArenaStats arena = m_Arena.GetStats();
+			return {
+				{ "arena_blocks", arena.blocks },
+				{ "arena_allocations", arena.allocations },
+				{ "arena_reserved_bytes", arena.reserved },
+				{ "arena_used_bytes", arena.used },
+				{ "arena_free_ranges", arena.freeRanges },
+				{ "arena_largest_free_bytes", arena.largestFree },
+				{ "arena_moved", m_Moved },
+			};
+		}
+	};
+
+	// a grid of size x size quads covering the window, each row one triangle strip and all rows in one draw with
+	// primitive restart between them. 254 quads a side is the biggest grid whose vertices fit 16 bit indices, 256 (the
+	// 32 bit variant) is just over: about the same work, twice the index bytes. Vertex colours alternate so a strip
+	// that doesn't restart shows up as triangles across the rows
+	class StripScene : public BenchmarkScene
+	{
+	private:
+		struct Vertex {
+			float position[2];
+			float colour[4];
+		};
+
+		ShaderCompiler m_Compiler;
+		ShaderPreprocessor m_Preprocessor;
+		Shader m_Shader;
+		Renderer m_Renderer;
+		std::unique_ptr<VertexBuffer> m_VertexBuffer;
+		std::unique_ptr<IndexBuffer> m_IndexBuffer;
+		VertexArray m_VertexArray;
+		unsigned int m_Size;		// quads per side
+
+	public:
+		StripScene(bool wide)
+			: m_Compiler(nullptr), m_Shader("res/shaders/colour.shader", {}, m_Preprocessor, m_Compiler), m_Size(wide ? 256 : 254)
+		{
+			const unsigned int side = m_Size + 1;		// vertices per side
+			std::vector<Vertex> vertices(side * side);
+			for (unsigned int y = 0; y < side; y++) {
+				for (unsigned int x = 0; x < side; x++) {
+					Vertex& vertex = vertices[y * side + x];
+					vertex.position[0] = -1.0f + 2.0f * x / m_Size;
+					vertex.position[1] = -1.0f + 2.0f * y / m_Size;
+					const float shade = (x + y) & 1 ? 1.0f : 0.4f;
+					vertex.colour[0] = shade * x / m_Size;
+					vertex.colour[1] = shade * y / m_Size;
+					vertex.colour[2] = shade * 0.5f;
+					vertex.colour[3] = 1.0f;
+				}
+			}
+
+			// row y zigzags between vertex rows y and y + 1, then a restart
+			std::vector<unsigned int> indices;
+			indices.reserve(m_Size * (side * 2 + 1));
+			for (unsigned int y = 0; y < m_Size; y++) {
+				for (unsigned int x = 0; x < side; x++) {
+					indices.push_back(y * side + x);
+					indices.push_back((y + 1) * side + x);
+				}
+				indices.push_back(0xFFFFFFFF);
+			}
+
+			m_VertexBuffer.reset(new VertexBuffer(vertices.data(), (unsigned int)vertices.size() * sizeof(Vertex)));
+			m_IndexBuffer.reset(new IndexBuffer(indices.data(), (unsigned int)indices.size(), GL_TRIANGLE_STRIP, true));
+
+			static constexpr auto layout = MakeVertexLayout<Vertex>(VERTEX_ATTRIBUTE(Vertex, position), VERTEX_ATTRIBUTE(Vertex, colour));
+			static_assert(layout.IsValid(), "StripScene::Vertex layout");
+			m_VertexArray.AddBuffer(*m_VertexBuffer, layout);
+			m_VertexArray.SetIndexBuffer(*m_IndexBuffer);
+
+			m_Shader.GetProgram(0);
+			m_Compiler.WaitAll();
+		}
+
+		const char* GetName() const override { return 256 == m_Size ? "strips-32" : "strips-16"; }
+
+		void Update(int /*frame*/) override {}
+
+		SceneStats Submit() override
+		{
+			SceneStats stats = { 0, 0, 0, 0 };
+			if (!m_Renderer.Draw(m_VertexArray, *m_IndexBuffer, m_Shader))
+				return stats;
+			stats.draws = 1;
+			stats.triangles = 2ull * m_Size * m_Size;
+			return stats;
+		}
+
+		std::vector<std::pair<std::string, double>> GetCounters() const override
+		{
+			return {
+				{ "index_bytes", m_IndexBuffer->GetIndexSize() },
+				{ "index_buffer_bytes", m_IndexBuffer->GetCount() * m_IndexBuffer->GetIndexSize() },
+			};
+		}
+	};
+
+	// the grid's vertices written from scratch every frame, straight into a persistently mapped StreamingVertexBuffer
+	// or, orphan, into a staging copy that's uploaded into a reallocated buffer. Compare their upload_mb_per_sec, and
+	// check stalls: the times Map() had to wait for the GPU to finish reading a region
+	class StreamScene : public BenchmarkScene
+	{
+	private:
+		struct Vertex {
+			float position[2];
+			float colour[4];
+		};
+
+		ShaderCompiler m_Compiler;
+		ShaderPreprocessor m_Preprocessor;
+		Shader m_Shader;
+		VertexArray m_VertexArray;
+		StreamingVertexBuffer m_VertexBuffer;
+		IndexBuffer m_IndexBuffer;
+		int m_Frame;
+
+	public:
+		StreamScene(bool persistent)
+			: m_Compiler(nullptr), m_Shader("res/shaders/colour.shader", {}, m_Preprocessor, m_Compiler),
+			m_VertexBuffer(GridQuads * 4 * sizeof(Vertex), 3, persistent),
+			m_IndexBuffer(BatchRenderer::GenerateIndices(GridQuads).data(), GridQuads * 6), m_Frame(0)
+		{
+			static constexpr auto layout = MakeVertexLayout<Vertex>(VERTEX_ATTRIBUTE(Vertex, position), VERTEX_ATTRIBUTE(Vertex, colour));
+			static_assert(layout.IsValid(), "StreamScene::Vertex layout");
+			m_VertexArray.AddBuffer(m_VertexBuffer, layout);
+			m_VertexArray.SetIndexBuffer(m_IndexBuffer);
+
+			if (persistent && !m_VertexBuffer.IsPersistent())
+				std::cout << "No ARB_buffer_storage, streaming falls back to orphaning" << std::endl;
+
+			m_Shader.GetProgram(0);
+			m_Compiler.WaitAll();
+		}
+
+		const char* GetName() const override { return m_VertexBuffer.IsPersistent() ? "stream" : "stream-orphan"; }
+
+		void Update(int frame) override
+		{
+			m_Frame = frame;
+		}
+
+		SceneStats Submit() override
+		{
+			SceneStats stats = { 0, 0, 0, 0 };
+			if (!m_Shader.Bind(0))
+				return stats;
+
+			m_VertexBuffer.ResetStats();
+			Vertex* vertex = (Vertex*)m_VertexBuffer.Map();
+			for (unsigned int i = 0; i < GridQuads; i++) {
+				float rect[4], colour[4];
+				GetGridQuad(i, m_Frame, rect, colour);
+				const float x[4] = { rect[0], rect[0] + rect[2], rect[0] + rect[2], rect[0] };
+				const float y[4] = { rect[1], rect[1], rect[1] + rect[3], rect[1] + rect[3] };
+				for (int corner = 0; corner < 4; corner++, vertex++) {
+					vertex->position[0] = x[corner];
+					vertex->position[1] = y[corner];
+					for (int c = 0; c < 4; c++)
+						vertex->colour[c] = colour[c];
+				}
+			}
+			m_VertexBuffer.Unmap(GridQuads * 4 * sizeof(Vertex));
+
+			m_VertexArray.Bind();
+			GLCall(glDrawElementsBaseVertex(GL_TRIANGLES, GridQuads * 6, m_IndexBuffer.GetType(), nullptr, m_VertexBuffer.GetOffset() / sizeof(Vertex)));
+			m_VertexBuffer.Fence();
+
+			stats.draws = 1;
+			stats.triangles = GridQuads * 2ull;
+			stats.uploaded = GridQuads * 4ull * sizeof(Vertex);
+			stats.stalls = m_VertexBuffer.GetStats().stalls;
+			return stats;
+		}
+	};
+
+	// a few dense spheres (small triangles, so vertex fetch and the vertex shader matter more than usual), with float
+	// vertices or, compressed, the same vertices quantized by VertexEncoder: 32 bytes against 16
+	class SphereScene : public BenchmarkScene
+	{
+	private:
+		struct Vertex {
+			float position[3];
+			float normal[3];
+			float texCoord[2];
+		};
+		struct CompressedVertex {
+			short position[4];			// snorm16, relative to the bounding box
+			Packed1010102 normal;
+			Half texCoord[2];
+		};
+
+		static const unsigned int Rings = 256;
+		static const unsigned int Segments = 512;
+		static const unsigned int Spheres = 6;
+
+		ShaderCompiler m_Compiler;
+		ShaderPreprocessor m_Preprocessor;
+		Shader m_Shader;
+		VertexArray m_VertexArray;
+		std::unique_ptr<VertexBuffer> m_VertexBuffer;
+		std::unique_ptr<IndexBuffer> m_IndexBuffer;
+		float m_Scale[3], m_Offset[3];
+		float m_Angle;
+		bool m_Compressed;
+
+	public:
+		SphereScene(bool compressed)
+			: m_Compiler(nullptr), m_Shader("res/shaders/sphere.shader", {}, m_Preprocessor, m_Compiler),
+			m_Scale{ 1.0f, 1.0f, 1.0f }, m_Offset{ 0.0f, 0.0f, 0.0f }, m_Angle(0.0f), m_Compressed(compressed)
+		{
+			std::vector<Vertex> vertices;
+			const float pi = 3.14159265f;
+			for (unsigned int ring = 0; ring <= Rings; ring++) {
+				float theta = pi * ring / Rings;
+				for (unsigned int segment = 0; segment <= Segments; segment++) {
+					float phi = 2.0f * pi * segment / Segments;
+					Vertex vertex;
+					vertex.normal[0] = std::sin(theta) * std::cos(phi);
+					vertex.normal[1] = std::cos(theta);
+					vertex.normal[2] = std::sin(theta) * std::sin(phi);
+					for (int c = 0; c < 3; c++)
+						vertex.position[c] = vertex.normal[c];
+					vertex.texCoord[0] = (float)segment / Segments;
+					vertex.texCoord[1] = (float)ring / Rings;
+					vertices.push_back(vertex);
+				}
+			}
+			std::vector<unsigned int> indices;
+			for (unsigned int ring = 0; ring < Rings; ring++) {
+				for (unsigned int segment = 0; segment < Segments; segment++) {
+					unsigned int v = ring * (Segments + 1) + segment;
+					unsigned int quad[6] = { v, v + 1, v + Segments + 1, v + 1, v + Segments + 2, v + Segments + 1 };
+					indices.insert(indices.end(), quad, quad + 6);
+				}
+			}
+
+			// both versions get the same optimized order, so only the vertex size differs
+			indices = MeshOptimizer::OptimizeVertexCache(indices.data(), (unsigned int)indices.size(), (unsigned int)vertices.size());
+			unsigned int vertexCount = MeshOptimizer::OptimizeVertexFetch(vertices.data(), sizeof(Vertex), (unsigned int)vertices.size(),
+				indices.data(), (unsigned int)indices.size());
+
+			if (compressed) {
+				std::vector<short> positions(vertexCount * 4);
+				std::vector<Packed1010102> normals(vertexCount);
+				std::vector<float> texCoords(vertexCount * 2);
+				std::vector<Half> halfTexCoords(vertexCount * 2);
+				VertexEncoder::EncodePositions(vertices[0].position, sizeof(Vertex), vertexCount, positions.data(), m_Scale, m_Offset);
+				VertexEncoder::EncodeNormals(vertices[0].normal, sizeof(Vertex), vertexCount, normals.data());
+				for (unsigned int i = 0; i < vertexCount; i++) {
+					texCoords[i * 2] = vertices[i].texCoord[0];
+					texCoords[i * 2 + 1] = vertices[i].texCoord[1];
+				}
+				VertexEncoder::EncodeHalf(texCoords.data(), vertexCount * 2, halfTexCoords.data());
+
+				std::vector<CompressedVertex> packed(vertexCount);
+				for (unsigned int i = 0; i < vertexCount; i++) {
+					for (int c = 0; c < 4; c++)
+						packed[i].position[c] = positions[i * 4 + c];
+					packed[i].normal = normals[i];
+					packed[i].texCoord[0] = halfTexCoords[i * 2];
+					packed[i].texCoord[1] = halfTexCoords[i * 2 + 1];
+				}
+
+				static constexpr auto layout = MakeVertexLayout<CompressedVertex>(VERTEX_ATTRIBUTE_NORMALISED(CompressedVertex, position),
+					VERTEX_ATTRIBUTE_NORMALISED(CompressedVertex, normal), VERTEX_ATTRIBUTE(CompressedVertex, texCoord));
+				static_assert(layout.IsValid() && layout.stride == 16, "SphereScene::CompressedVertex layout");
+				m_VertexBuffer.reset(new VertexBuffer(packed.data(), vertexCount * sizeof(CompressedVertex)));
+				m_VertexArray.AddBuffer(*m_VertexBuffer, layout);
+			}
+			else {
+				static constexpr auto layout = MakeVertexLayout<Vertex>(VERTEX_ATTRIBUTE(Vertex, position),
+					VERTEX_ATTRIBUTE(Vertex, normal), VERTEX_ATTRIBUTE(Vertex, texCoord));
+				static_assert(layout.IsValid() && layout.stride == 32, "SphereScene::Vertex layout");
+				m_VertexBuffer.reset(new VertexBuffer(vertices.data(), vertexCount * sizeof(Vertex)));
+				m_VertexArray.AddBuffer(*m_VertexBuffer, layout);
+			}
+			m_IndexBuffer.reset(new IndexBuffer(indices.data(), (unsigned int)indices.size()));
+			m_VertexArray.SetIndexBuffer(*m_IndexBuffer);
+
+			m_Shader.GetProgram(0);
+			m_Compiler.WaitAll();
+		}
+
+		~SphereScene()
+		{
+			GLStateCache::Get().SetDepthTest(false);
+		}
+
+		const char* GetName() const override { return m_Compressed ? "sphere-compressed" : "sphere"; }
+
+		void Update(int frame) override
+		{
+			m_Angle = frame * 0.01f;
+		}
+
+		SceneStats Submit() override
+		{
+			static constexpr UniformName u_Scale("u_Scale");
+			static constexpr UniformName u_Offset("u_Offset");
+			static constexpr UniformName u_Placement("u_Placement");
+
+			SceneStats stats = { 0, 0, 0, 0 };
+			if (!m_Shader.Bind(0))
+				return stats;
+
+			GLStateCache::Get().SetDepthTest(true);
+			GLStateCache::Get().SetDepthWrite(true);
+			GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+
+			m_Shader.SetUniform(u_Scale, m_Scale[0], m_Scale[1], m_Scale[2]);
+			m_Shader.SetUniform(u_Offset, m_Offset[0], m_Offset[1], m_Offset[2]);
+			m_VertexArray.Bind();
+			for (unsigned int i = 0; i < Spheres; i++) {
+				m_Shader.SetUniform(u_Placement, -0.6f + 0.6f * (i % 3), -0.45f + 0.9f * (i / 3), 0.38f, m_Angle + i);
+				GLCall(glDrawElements(GL_TRIANGLES, m_IndexBuffer->GetCount(), m_IndexBuffer->GetType(), nullptr));
+			}
+
+			stats.draws = Spheres;
+			stats.triangles = Spheres * (m_IndexBuffer->GetCount() / 3ull);
+			return stats;
+		}
+	};
+
+	// a 100 x 100 grid of objects that differ in every way a draw can: one of 8 meshes (each with its own vertex array),
+	// plain or TEXTURED, one of 4 textures, and every 8th one translucent - each picked at random, so submitting them
+	// in grid order changes state on nearly every draw. They go through a RenderQueue, sorted by key or replayed in
+	// submission order. Nothing overlaps, the two give the same image; compare their state_changes_per_frame
+	class QueueScene : public BenchmarkScene
+	{
+	private:
+		static const unsigned int MeshCount = 8;
+		static const unsigned int TextureCount = 4;
+		static const unsigned int Columns = 100;
+		static const unsigned int Objects = Columns * Columns;
+
+		struct Object {
+			unsigned int mesh;
+			unsigned int texture;		// 0 untextured, else 1 + index into m_Textures
+			bool translucent;
+			float depth;
+		};
+
+		ShaderCompiler m_Compiler;
+		ShaderPreprocessor m_Preprocessor;
+		Shader m_Shader;
+		unsigned int m_Textured;		// keyword mask
+		std::vector<std::unique_ptr<VertexBuffer>> m_VertexBuffers;
+		std::vector<std::unique_ptr<IndexBuffer>> m_IndexBuffers;
+		std::vector<std::unique_ptr<VertexArray>> m_VertexArrays;
+		std::vector<unsigned int> m_Textures;
+		std::vector<Object> m_Objects;
+		RenderQueue m_Queue;
+		int m_Frame;
+
+	public:
+		QueueScene(bool sorted)
+			: m_Compiler(nullptr), m_Shader("res/shaders/queue.shader", { "TEXTURED" }, m_Preprocessor, m_Compiler),
+			m_Textured(m_Shader.GetKeywordMask("TEXTURED")), m_Queue(sorted), m_Frame(0)
+		{
+			VertexBufferLayout layout;
+			layout.Push<float>(2);
+			for (unsigned int i = 0; i < MeshCount; i++) {
+				std::vector<float> vertices;
+				std::vector<unsigned int> indices;
+				GeneratePolygon(3 + i, vertices, indices);
+				m_VertexBuffers.emplace_back(new VertexBuffer(vertices.data(), (unsigned int)vertices.size() * sizeof(float)));
+				m_IndexBuffers.emplace_back(new IndexBuffer(indices.data(), (unsigned int)indices.size()));
+				m_VertexArrays.emplace_back(new VertexArray());
+				m_VertexArrays.back()->AddBuffer(*m_VertexBuffers[i], layout);
+				m_VertexArrays.back()->SetIndexBuffer(*m_IndexBuffers[i]);
+			}
+
+			for (unsigned int i = 0; i < TextureCount; i++) {
+				unsigned int texture;
+				unsigned int texels[4] = { 0xFFFFFFFF, 0xFF000000u | ((i + 1) * 0x3F1F5F), 0xFF000000u | ((i + 1) * 0x3F1F5F), 0xFFFFFFFF };
+				GLCall(glGenTextures(1, &texture));
+				GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, texture);
+				GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+				GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+				GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels));
+				m_Textures.push_back(texture);
+			}
+
+			// the same objects every run
+			std::mt19937 random(1234);
+			for (unsigned int i = 0; i < Objects; i++) {
+				Object object;
+				object.mesh = random() % MeshCount;
+				object.texture = random() % (TextureCount + 1);
+				object.translucent = 0 == random() % 8;
+				object.depth = (random() % 1000) / 1000.0f;
+				m_Objects.push_back(object);
+			}
+
+			m_Shader.GetProgram(0);
+			m_Shader.GetProgram(m_Textured);
+			m_Compiler.WaitAll();
+		}
+
+		~QueueScene()
+		{
+			for (unsigned int texture : m_Textures)
+				GLStateCache::Get().DeleteTexture(texture);
+		}
+
+		const char* GetName() const override { return m_Queue.IsSorted() ? "queue-sorted" : "queue"; }
+
+		void Update(int frame) override
+		{
+			m_Frame = frame;
+		}
+
+		SceneStats Submit() override
+		{
+			static constexpr UniformName u_Rect("u_Rect");
+			static constexpr UniformName u_Colour("u_Colour");
+
+			SceneStats stats = { 0, 0, 0, 0 };
+			const float size = 2.0f / Columns;
+			for (unsigned int i = 0; i < Objects; i++) {
+				const Object& object = m_Objects[i];
+				const bool textured = object.texture != 0;
+
+				// the material is everything else the draw binds: texture and mesh
+				RenderCommand command = {};
+				command.key = RenderQueue::MakeKey(0, object.translucent, textured ? 1 : 0, object.texture << 8 | object.mesh, object.depth);
+				command.shader = &m_Shader;
+				command.mask = textured ? m_Textured : 0;
+				command.vertexArray = m_VertexArrays[object.mesh].get();
+				command.indexBuffer = m_IndexBuffers[object.mesh].get();
+				command.texture = textured ? m_Textures[object.texture - 1] : 0;
+				m_Queue.Submit(command);
+				m_Queue.AddUniform(u_Rect, 4, -1.0f + (i % Columns) * size, -1.0f + (i / Columns) * size, size * 0.8f, size * 0.8f);
+				m_Queue.AddUniform(u_Colour, 4, ((i + m_Frame) & 255) / 255.0f, object.depth, 0.5f, object.translucent ? 0.5f : 1.0f);
+
+				stats.triangles += m_IndexBuffers[object.mesh]->GetCount() / 3;
+			}
+
+			const RenderQueueStats& queueStats = m_Queue.Execute();
+			stats.draws = queueStats.draws;
+			GLStateCache::Get().SetBlend(false);		// leave it the way the other scenes expect
+			GLStateCache::Get().SetDepthWrite(true);
+			return stats;
+		}
+	};
+
+	// frame preparation spread over threads: 100k objects orbiting over an area 4 times the screen's width, recorded by
+	// a ParallelRecorder with the given number of threads. Every thread moves its objects, culls the ones off screen and
+	// for the rest writes rect and colour into a persistently mapped StreamingVertexBuffer (at the object's slot, so
+	// threads never share memory) and records a command reading them with its base instance. The render thread merges,
+	// sorts and draws. Recording happens in Update(), so update_ms is what scales with the threads
+	class RecordScene : public BenchmarkScene
+	{
+	private:
+		static const unsigned int MeshCount = 8;
+		static const unsigned int Objects = 100000;
+
+		struct Object {
+			float x, y;			// centre of its orbit
+			float phase;
+			float depth;
+			unsigned int mesh;
+		};
+
+		struct DrawData {
+			float rect[4];
+			float colour[4];
+		};
+
+		ShaderCompiler m_Compiler;
+		ShaderPreprocessor m_Preprocessor;
+		Shader m_Shader;
+		StreamingVertexBuffer m_DrawBuffer;
+		std::vector<std::unique_ptr<VertexBuffer>> m_VertexBuffers;
+		std::vector<std::unique_ptr<IndexBuffer>> m_IndexBuffers;
+		std::vector<std::unique_ptr<VertexArray>> m_VertexArrays;
+		std::vector<Object> m_Objects;
+		ParallelRecorder m_Recorder;
+		RenderQueue m_Queue;
+		DrawData* m_DrawData;		// this frame's region
+		unsigned int m_BaseInstance;
+		std::vector<unsigned long long> m_Triangles;	// recorded by each thread
+		std::string m_Name;
+
+	public:
+		RecordScene(unsigned int threads)
+			: m_Compiler(nullptr), m_Shader("res/shaders/meshes.shader", {}, m_Preprocessor, m_Compiler),
+			m_DrawBuffer(Objects * sizeof(DrawData)), m_Recorder(threads), m_Triangles(threads), m_Name("record-" + std::to_string(threads))
+		{
+			VertexBufferLayout layout;
+			layout.Push<float>(2);
+			VertexBufferLayout drawLayout(1);
+			drawLayout.Push<float>(4);		// rect
+			drawLayout.Push<float>(4);		// colour
+			for (unsigned int i = 0; i < MeshCount; i++) {
+				std::vector<float> vertices;
+				std::vector<unsigned int> indices;
+				GeneratePolygon(3 + i, vertices, indices);
+				m_VertexBuffers.emplace_back(new VertexBuffer(vertices.data(), (unsigned int)vertices.size() * sizeof(float)));
+				m_IndexBuffers.emplace_back(new IndexBuffer(indices.data(), (unsigned int)indices.size()));
+				m_VertexArrays.emplace_back(new VertexArray());
+				m_VertexArrays.back()->AddBuffer(*m_VertexBuffers[i], layout);
+				m_VertexArrays.back()->AddBuffer(m_DrawBuffer, drawLayout);
+				m_VertexArrays.back()->SetIndexBuffer(*m_IndexBuffers[i]);
+			}
+
+			std::mt19937 random(1234);
+			for (unsigned int i = 0; i < Objects; i++) {
+				Object object;
+				object.x = -4.0f + (random() % 8000) / 1000.0f;
+				object.y = -4.0f + (random() % 8000) / 1000.0f;
+				object.phase = (random() % 6283) / 1000.0f;
+				object.depth = (random() % 1000) / 1000.0f;
+				object.mesh = random() % MeshCount;
+				m_Objects.push_back(object);
+			}
+
+			// the first frame's region, every Submit() maps the next one
+			m_DrawData = (DrawData*)m_DrawBuffer.Map();
+			m_BaseInstance = m_DrawBuffer.GetOffset() / sizeof(DrawData);
+
+			m_Shader.GetProgram(0);
+			m_Compiler.WaitAll();
+		}
+
+		const char* GetName() const override { return m_Name.c_str(); }
+
+		void Update(int frame) override
+		{
+			const float time = frame * 0.02f;
+			const float size = 0.02f;
+			m_Recorder.Record(Objects, [&](unsigned int thread, unsigned int first, unsigned int last, RenderQueue& queue) {
+				unsigned long long triangles = 0;
+				for (unsigned int i = first; i < last; i++) {
+					const Object& object = m_Objects[i];
+					const float x = object.x + 0.25f * std::cos(object.phase + time);
+					const float y = object.y + 0.25f * std::sin(object.phase + time);
+					if (x + size < -1.0f || x > 1.0f || y + size < -1.0f || y > 1.0f)
+						continue;		// off screen
+
+					DrawData& data = m_DrawData[i];
+					data.rect[0] = x;
+					data.rect[1] = y;
+					data.rect[2] = size;
+					data.rect[3] = size;
+					data.colour[0] = ((i + frame) & 255) / 255.0f;
+					data.colour[1] = object.depth;
+					data.colour[2] = 0.5f;
+					data.colour[3] = 1.0f;
+
+					RenderCommand command = {};
+					command.key = RenderQueue::MakeKey(0, false, 0, object.mesh, object.depth);
+					command.shader = &m_Shader;
+					command.vertexArray = m_VertexArrays[object.mesh].get();
+					command.indexBuffer = m_IndexBuffers[object.mesh].get();
+					command.baseInstance = m_BaseInstance + i;
+					queue.Submit(command);
+					triangles += 3 + object.mesh;
+				}
+				m_Triangles[thread] = triangles;
+			});
+		}
+
+		SceneStats Submit() override
+		{
+			m_DrawBuffer.Unmap(Objects * sizeof(DrawData));
+			m_Recorder.Merge(m_Queue);
+			SceneStats stats = { 0, 0, m_DrawBuffer.IsPersistent() ? 0 : Objects * sizeof(DrawData), 0 };
+			stats.draws = m_Queue.Execute().draws;
+			for (unsigned long long triangles : m_Triangles)
+				stats.triangles += triangles;
+			m_DrawBuffer.Fence();
+
+			m_DrawBuffer.ResetStats();
+			m_DrawData = (DrawData*)m_DrawBuffer.Map();
+			m_BaseInstance = m_DrawBuffer.GetOffset() / sizeof(DrawData);
+			stats.stalls = m_DrawBuffer.GetStats().stalls;
+			return stats;
+		}
+	};
+
+	const float QuadScene::Positions[8] = {
+		-0.5f, -0.5f,
+		 0.5f, -0.5f,
+		 0.5f,  0.5f,
+		-0.5f,  0.5f,
+	};
+
+	const unsigned int QuadScene::Indices[6] = {
+		0, 1, 2,
+		2, 3, 0
+	};
+}
+
+const char * BenchmarkScene::GetSceneNames()
+{
+	return "quad, quads, quads-ubo, quads-ubo-subdata, batch, batch-textured, instanced, meshes, meshes-indirect, buffers, buffers-shared, arena, arena-defragmented, strips-16, strips-32, stream, stream-orphan, sphere, sphere-compressed, queue, queue-sorted, record-<threads> (1 to 64)";
+}
+
+std::unique_ptr<BenchmarkScene> BenchmarkScene::Create(const std::string & name)
+{
+	if (name == "quad")
+		return std::unique_ptr<BenchmarkScene>(new QuadScene());
+	if (name == "quads")
+		return std::unique_ptr<BenchmarkScene>(new QuadsScene());
+	if (name == "quads-ubo" || name == "quads-ubo-subdata")
+		return std::unique_ptr<BenchmarkScene>(new UniformsScene(name == "quads-ubo-subdata"));
+	if (name == "batch" || name == "batch-textured")
+		return std::unique_ptr<BenchmarkScene>(new BatchScene(name == "batch-textured"));
+	if (name == "instanced")
+		return std::unique_ptr<BenchmarkScene>(new InstancedScene());
+	if (name == "meshes" || name == "meshes-indirect")
+		return std::unique_ptr<BenchmarkScene>(new MeshesScene(name == "meshes-indirect"));
+	if (name == "buffers" || name == "buffers-shared")
+		return std::unique_ptr<BenchmarkScene>(new BuffersScene(name == "buffers-shared"));
+	if (name == "arena" || name == "arena-defragmented")
+		return std::unique_ptr<BenchmarkScene>(new ArenaScene(name == "arena-defragmented"));
+	if (name == "strips-16" || name == "strips-32")
+		return std::unique_ptr<BenchmarkScene>(new StripScene(name == "strips-32"));
+	if (name == "stream" || name == "stream-orphan")
+		return std::unique_ptr<BenchmarkScene>(new StreamScene(name == "stream"));
+	if (name == "sphere" || name == "sphere-compressed")
+		return std::unique_ptr<BenchmarkScene>(new SphereScene(name == "sphere-compressed"));
+	if (name == "queue" || name == "queue-sorted")
+		return std::unique_ptr<BenchmarkScene>(new QueueScene(name == "queue-sorted"));
+	if (name.compare(0, 7, "record-") == 0) {
+		const int threads = atoi(name.c_str() + 7);
+		if (threads >= 1 && threads <= 64)
+			return std::unique_ptr<BenchmarkScene>(new RecordScene(threads));
+	}
+	return nullptr;
+}
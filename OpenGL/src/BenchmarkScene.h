@@ -0,0 +1,33 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct SceneStats {
+	unsigned int draws;				// draw calls issued
+	unsigned long long triangles;
+	unsigned long long uploaded;	// bytes of vertex data sent this frame
+	unsigned int stalls;			// waits for the GPU to release a buffer region (fences that hadn't passed)
+};
+
+// something for FrameBenchmark to draw, picked by name on the command line. Scenes create their GL resources in the
+// constructor (a context is current by then) and must be ready to draw as soon as it returns.
+class BenchmarkScene
+{
+public:
+	virtual ~BenchmarkScene() {}
+
+	/* the scenes Create() knows, for the usage message */
+	static const char* GetSceneNames();
+	/* nullptr if there's no scene with that name */
+	static std::unique_ptr<BenchmarkScene> Create(const std::string& name);
+
+	virtual const char* GetName() const = 0;
+	/* CPU side work for the frame (animation, culling...), no GL calls */
+	virtual void Update(int frame) = 0;
+	/* issues the frame's GL commands */
+	virtual SceneStats Submit() = 0;
+	/* numbers only this scene has, added to the JSON as "name": value once the run is over */
+	virtual std::vector<std::pair<std::string, double>> GetCounters() const { return {}; }
+};
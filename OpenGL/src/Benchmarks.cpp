@@ -0,0 +1,455 @@
+#include "Benchmarks.h"
+#include "ShaderParser.h"
+#include "BenchmarkScene.h"
+#include "FrameBenchmark.h"
+#include "GLContext.h"
+#include "MeshOptimizer.h"
+#include "RenderQueue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace {
+
+	std::atomic<unsigned long long> s_Allocations(0);		// operator new calls so far, all threads
+}
+
+// the whole program allocates through these so the benchmarks can count allocations: one relaxed increment on top of
+// malloc, nothing else changes
+void* operator new(std::size_t size)
+{
+	s_Allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* memory = std::malloc(size ? size : 1))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t /*size*/) noexcept
+{
+	std::free(memory);
+}
+
+namespace {
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	// the original ParseShader: getline, a find() per line and a stringstream per stage, copied out as strings
+	size_t LegacyParseShader(const std::string& filepath, std::string (&sources)[6])
+	{
+		static const char* names[] = { "vertex", "fragment", "geometry", "tesscontrol", "tessevaluation", "compute" };
+
+		std::ifstream stream(filepath);
+		std::string line;
+		std::stringstream ss[6];
+		int type = -1;
+
+		while (getline(stream, line)) {
+			if (line.find("#shader") != std::string::npos) {
+				for (int i = 0; i < 6; i++) {
+					if (line.find(names[i]) != std::string::npos) {
+						type = i;
+						break;
+					}
+				}
+			}
+			else if (-1 != type) {
+				ss[type] << line << '\n';
+			}
+		}
+
+		size_t total = 0;
+		for (int i = 0; i < 6; i++) {
+			sources[i] = ss[i].str();
+			total += sources[i].size();
+		}
+		return total;
+	}
+
+	// a shader library with every stage type, each a few thousand lines long
+	std::string GenerateLibrary(const std::string& filepath)
+	{
+		static const char* stages[] = { "vertex", "fragment", "geometry", "tesscontrol", "tessevaluation", "compute" };
+
+		std::ofstream stream(filepath, std::ios::trunc);
+		for (int copy = 0; copy < 4; copy++) {
+			for (const char* stage : stages) {
+				stream << "#shader " << stage << "\n#version 430 core\n\n";
+				for (int i = 0; i < 2000; i++)
+					stream << "vec4 function_" << i << "(vec4 a, vec4 b) { return a * b + vec4(" << i << ".0); }	// padding comment\n";
+				stream << "void main()\n{\n}\n\n";
+			}
+		}
+		return filepath;
+	}
+
+	struct TestMesh {
+		const char* name = "";
+		std::vector<float> positions;		// x, y, z
+		std::vector<unsigned int> indices;
+	};
+
+	TestMesh GenerateGrid(int size)
+	{
+		TestMesh mesh;
+		mesh.name = "grid";
+		for (int y = 0; y <= size; y++) {
+			for (int x = 0; x <= size; x++) {
+				mesh.positions.push_back((float)x);
+				mesh.positions.push_back((float)y);
+				mesh.positions.push_back(0.0f);
+			}
+		}
+		for (int y = 0; y < size; y++) {
+			for (int x = 0; x < size; x++) {
+				unsigned int v = y * (size + 1) + x;
+				unsigned int quad[6] = { v, v + 1, v + size + 2, v + size + 2, v + size + 1, v };
+				mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+			}
+		}
+		return mesh;
+	}
+
+	TestMesh GenerateSphere(int size)
+	{
+		TestMesh mesh;
+		mesh.name = "sphere";
+		const float pi = 3.14159265f;
+		for (int ring = 0; ring <= size; ring++) {
+			float theta = pi * ring / size;
+			for (int segment = 0; segment <= size; segment++) {
+				float phi = 2.0f * pi * segment / size;
+				mesh.positions.push_back(std::sin(theta) * std::cos(phi));
+				mesh.positions.push_back(std::cos(theta));
+				mesh.positions.push_back(std::sin(theta) * std::sin(phi));
+			}
+		}
+		for (int ring = 0; ring < size; ring++) {
+			for (int segment = 0; segment < size; segment++) {
+				unsigned int v = ring * (size + 1) + segment;
+				unsigned int quad[6] = { v, v + size + 1, v + 1, v + 1, v + size + 1, v + size + 2 };
+				mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+			}
+		}
+		return mesh;
+	}
+
+	// the triangles in random order, like a mesh exported without any care
+	TestMesh Shuffle(TestMesh mesh, const char* name)
+	{
+		std::vector<unsigned int> triangles(mesh.indices.size() / 3);
+		for (unsigned int i = 0; i < triangles.size(); i++)
+			triangles[i] = i;
+		std::shuffle(triangles.begin(), triangles.end(), std::mt19937(1234));
+
+		std::vector<unsigned int> indices;
+		for (unsigned int t : triangles)
+			indices.insert(indices.end(), mesh.indices.begin() + t * 3, mesh.indices.begin() + t * 3 + 3);
+		mesh.indices.swap(indices);
+		mesh.name = name;
+		return mesh;
+	}
+
+	void PrintCacheStats(const char* pass, const TestMesh& mesh, const std::vector<unsigned int>& indices, double ms)
+	{
+		VertexCacheStats stats = MeshOptimizer::AnalyzeVertexCache(indices.data(), (unsigned int)indices.size(),
+			(unsigned int)mesh.positions.size() / 3);
+		std::cout << "    " << pass << "ACMR " << stats.acmr << ", ATVR " << stats.atvr;
+		if (ms >= 0.0)
+			std::cout << ", " << ms << "ms";
+		std::cout << std::endl;
+	}
+
+	// the triangles as a sorted list, each rotated to start at its smallest index (which keeps the winding), so two
+	// index lists with the same triangles in any order compare equal
+	std::vector<unsigned int> SortedTriangles(const std::vector<unsigned int>& indices)
+	{
+		struct Triangle {
+			unsigned int v[3];
+			bool operator<(const Triangle& other) const { return std::lexicographical_compare(v, v + 3, other.v, other.v + 3); }
+		};
+
+		std::vector<Triangle> triangles(indices.size() / 3);
+		for (unsigned int t = 0; t < triangles.size(); t++) {
+			const unsigned int* corners = &indices[t * 3];
+			unsigned int first = corners[0] <= corners[1] && corners[0] <= corners[2] ? 0 : corners[1] <= corners[2] ? 1 : 2;
+			for (unsigned int i = 0; i < 3; i++)
+				triangles[t].v[i] = corners[(first + i) % 3];
+		}
+		std::sort(triangles.begin(), triangles.end());
+
+		std::vector<unsigned int> sorted;
+		sorted.reserve(triangles.size() * 3);
+		for (const Triangle& triangle : triangles)
+			sorted.insert(sorted.end(), triangle.v, triangle.v + 3);
+		return sorted;
+	}
+
+	// a reordering pass has to keep every triangle and, if the mesh was in no useful order (lower: shuffled), lower the
+	// ACMR. A small enough grid in scanline order is about as good as it gets already, Tipsify can come out worse
+	bool CheckReorder(const char* pass, const TestMesh& mesh, const std::vector<unsigned int>& indices, bool lower)
+	{
+		const unsigned int vertexCount = (unsigned int)mesh.positions.size() / 3;
+		const float before = MeshOptimizer::AnalyzeVertexCache(mesh.indices.data(), (unsigned int)mesh.indices.size(), vertexCount).acmr;
+		const float after = MeshOptimizer::AnalyzeVertexCache(indices.data(), (unsigned int)indices.size(), vertexCount).acmr;
+
+		bool ok = true;
+		if (SortedTriangles(indices) != SortedTriangles(mesh.indices)) {
+			std::cout << "    " << pass << "the triangles changed" << std::endl;
+			ok = false;
+		}
+		if (lower && after >= before) {
+			std::cout << "    " << pass << "ACMR didn't go down: " << before << " -> " << after << std::endl;
+			ok = false;
+		}
+		return ok;
+	}
+
+	// every corner has to see the same position after the remap, vertices have to come in the order they're first
+	// used, and unreferenced ones have to go: the mesh gets an extra vertex nothing uses
+	bool CheckVertexFetch(const TestMesh& mesh, const std::vector<unsigned int>& indices)
+	{
+		std::vector<float> positions = mesh.positions;
+		positions.insert(positions.end(), { -1.0f, -1.0f, -1.0f });
+		std::vector<unsigned int> remapped = indices;
+		const unsigned int vertexCount = (unsigned int)positions.size() / 3;
+		const unsigned int kept = MeshOptimizer::OptimizeVertexFetch(positions.data(), 3 * sizeof(float), vertexCount,
+			remapped.data(), (unsigned int)remapped.size());
+
+		if (kept != vertexCount - 1) {
+			std::cout << "    vertex fetch: kept " << kept << " of " << vertexCount << " vertices, expected " << vertexCount - 1 << std::endl;
+			return false;
+		}
+		unsigned int next = 0;		// the first vertex not used yet
+		for (unsigned int i = 0; i < remapped.size(); i++) {
+			if (remapped[i] >= kept || 0 != std::memcmp(&positions[remapped[i] * 3], &mesh.positions[indices[i] * 3], 3 * sizeof(float))) {
+				std::cout << "    vertex fetch: corner " << i << " doesn't point at its old vertex" << std::endl;
+				return false;
+			}
+			if (remapped[i] > next) {
+				std::cout << "    vertex fetch: vertex " << remapped[i] << " is used before vertex " << next << std::endl;
+				return false;
+			}
+			if (remapped[i] == next)
+				next++;
+		}
+		return true;
+	}
+}
+
+int RunParserBenchmark(const char * filepath, int iterations)
+{
+	bool generated = !filepath;
+	std::string path = generated ? GenerateLibrary("parser_bench.shader") : std::string(filepath);
+	if (iterations <= 0)
+		iterations = 1;
+
+	// warm the file cache so both parsers are measured on the same footing
+	std::string legacySources[6];
+	size_t legacyBytes = LegacyParseShader(path, legacySources);
+
+	unsigned long long allocations = s_Allocations;
+	auto start = Clock::now();
+	for (int i = 0; i < iterations; i++)
+		legacyBytes = LegacyParseShader(path, legacySources);
+	double legacyMs = MillisecondsSince(start) / iterations;
+	double legacyAllocations = (double)(s_Allocations - allocations) / iterations;
+
+	ShaderFile file;
+	size_t bytes = 0;
+	allocations = s_Allocations;
+	start = Clock::now();
+	for (int i = 0; i < iterations; i++) {
+		file.Load(path);
+		bytes = 0;
+		for (const auto& stage : file.GetStages())
+			bytes += stage.source.length;
+	}
+	double parserMs = MillisecondsSince(start) / iterations;
+	double parserAllocations = (double)(s_Allocations - allocations) / iterations;
+
+	std::cout << "Parser benchmark: " << path << ", " << file.GetStages().size() << " stages, " << iterations << " iterations" << std::endl;
+	std::cout << "  getline/stringstream: " << legacyMs << "ms, " << legacyAllocations << " allocations per parse (" << legacyBytes << " bytes)" << std::endl;
+	std::cout << "  ShaderFile:           " << parserMs << "ms, " << parserAllocations << " allocations per parse (" << bytes << " bytes)" << std::endl;
+	std::cout << "  speedup: " << (parserMs > 0.0 ? legacyMs / parserMs : 0.0) << "x, "
+		<< (parserAllocations > 0.0 ? legacyAllocations / parserAllocations : 0.0) << "x fewer allocations" << std::endl;
+
+	if (generated)
+		std::remove(path.c_str());
+	return 0;
+}
+
+int RunMeshBenchmark(int size, int iterations)
+{
+	if (size <= 0)
+		size = 256;
+	if (iterations <= 0)
+		iterations = 1;
+
+	TestMesh grid = GenerateGrid(size);
+	TestMesh meshes[] = { grid, Shuffle(grid, "grid (shuffled)"), Shuffle(GenerateSphere(size), "sphere (shuffled)") };
+
+	std::cout << "Mesh optimizer benchmark: FIFO cache of " << MeshOptimizer::DefaultCacheSize << ", " << iterations << " iterations" << std::endl;
+	for (TestMesh& mesh : meshes) {
+		const unsigned int indexCount = (unsigned int)mesh.indices.size();
+		const unsigned int vertexCount = (unsigned int)mesh.positions.size() / 3;
+		std::cout << "  " << mesh.name << ": " << indexCount / 3 << " triangles, " << vertexCount << " vertices" << std::endl;
+		PrintCacheStats("original:       ", mesh, mesh.indices, -1.0);
+
+		std::vector<unsigned int> indices;
+		auto start = Clock::now();
+		for (int i = 0; i < iterations; i++)
+			indices = MeshOptimizer::OptimizeVertexCache(mesh.indices.data(), indexCount, vertexCount);
+		PrintCacheStats("vertex cache:   ", mesh, indices, MillisecondsSince(start) / iterations);
+
+		start = Clock::now();
+		for (int i = 0; i < iterations; i++)
+			indices = MeshOptimizer::OptimizeOverdraw(mesh.indices.data(), indexCount, mesh.positions.data(), 3 * sizeof(float), vertexCount);
+		PrintCacheStats("overdraw:       ", mesh, indices, MillisecondsSince(start) / iterations);
+
+		// leaves the cache order alone, so only the time is interesting
+		std::vector<float> positions;
+		std::vector<unsigned int> remapped;
+		double fetchMs = 0.0;
+		for (int i = 0; i < iterations; i++) {
+			positions = mesh.positions;
+			remapped = indices;
+			start = Clock::now();
+			MeshOptimizer::OptimizeVertexFetch(positions.data(), 3 * sizeof(float), vertexCount, remapped.data(), indexCount);
+			fetchMs += MillisecondsSince(start);
+		}
+		PrintCacheStats("vertex fetch:   ", mesh, remapped, fetchMs / iterations);
+	}
+	return 0;
+}
+
+int RunMeshTests(int size)
+{
+	// smaller meshes fit the cache nearly whole, no order does much better than another
+	if (size < 8)
+		size = 8;
+
+	TestMesh grid = GenerateGrid(size);
+	TestMesh meshes[] = { grid, Shuffle(grid, "grid (shuffled)"), Shuffle(GenerateSphere(size), "sphere (shuffled)") };
+
+	std::cout << "Mesh optimizer tests: " << size << " x " << size << " meshes" << std::endl;
+	int failed = 0;
+	for (TestMesh& mesh : meshes) {
+		const unsigned int indexCount = (unsigned int)mesh.indices.size();
+		const unsigned int vertexCount = (unsigned int)mesh.positions.size() / 3;
+
+		std::vector<unsigned int> cache = MeshOptimizer::OptimizeVertexCache(mesh.indices.data(), indexCount, vertexCount);
+		std::vector<unsigned int> overdraw = MeshOptimizer::OptimizeOverdraw(mesh.indices.data(), indexCount, mesh.positions.data(),
+			3 * sizeof(float), vertexCount);
+		const bool shuffled = &mesh != &meshes[0];
+		bool ok = CheckReorder("vertex cache: ", mesh, cache, shuffled);
+		ok = CheckReorder("overdraw: ", mesh, overdraw, shuffled) && ok;
+		ok = CheckVertexFetch(mesh, overdraw) && ok;
+
+		std::cout << "  " << mesh.name << ": " << (ok ? "ok" : "FAILED") << std::endl;
+		if (!ok)
+			failed++;
+	}
+	return failed ? 1 : 0;
+}
+
+int RunSortBenchmark(int count, int iterations)
+{
+	if (count <= 0)
+		count = 100000;
+	if (iterations <= 0)
+		iterations = 1;
+
+	// keys like a frame's worth of commands: a few layers, some translucent, a few dozen shaders and hundreds of
+	// materials, depths spread over the whole range
+	std::mt19937 random(1234);
+	std::vector<RenderQueue::SortItem> items(count);
+	for (int i = 0; i < count; i++) {
+		const unsigned long long key = RenderQueue::MakeKey(random() % 4, 0 == random() % 8, random() % 32, random() % 512,
+			(random() % 100000) / 100000.0f);
+		items[i] = { key, (unsigned int)i };
+	}
+
+	std::cout << "Render queue sort benchmark: " << count << " commands, " << iterations << " iterations" << std::endl;
+
+	std::vector<RenderQueue::SortItem> radix, scratch;
+	double radixMs = 0.0;
+	for (int i = 0; i < iterations; i++) {
+		radix = items;
+		auto start = Clock::now();
+		RenderQueue::Sort(radix, scratch);
+		radixMs += MillisecondsSince(start);
+	}
+
+	auto less = [](const RenderQueue::SortItem& a, const RenderQueue::SortItem& b) { return a.key < b.key; };
+	std::vector<RenderQueue::SortItem> stable;
+	double stableMs = 0.0;
+	for (int i = 0; i < iterations; i++) {
+		stable = items;
+		auto start = Clock::now();
+		std::stable_sort(stable.begin(), stable.end(), less);
+		stableMs += MillisecondsSince(start);
+	}
+
+	std::vector<RenderQueue::SortItem> unstable;
+	double unstableMs = 0.0;
+	for (int i = 0; i < iterations; i++) {
+		unstable = items;
+		auto start = Clock::now();
+		std::sort(unstable.begin(), unstable.end(), less);
+		unstableMs += MillisecondsSince(start);
+	}
+
+	// both stable, so the same order down to the commands with equal keys
+	for (int i = 0; i < count; i++) {
+		if (radix[i].index != stable[i].index) {
+			std::cout << "  radix sort order differs from std::stable_sort at " << i << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << "  radix sort:       " << radixMs / iterations << " ms (" << count * (iterations / radixMs) / 1000.0 << " M commands/s)" << std::endl;
+	std::cout << "  std::stable_sort: " << stableMs / iterations << " ms (" << count * (iterations / stableMs) / 1000.0 << " M commands/s)" << std::endl;
+	std::cout << "  std::sort:        " << unstableMs / iterations << " ms (" << count * (iterations / unstableMs) / 1000.0 << " M commands/s)" << std::endl;
+	return 0;
+}
+
+int RunFrameBenchmark(GLContext & context, const std::string & scene, int warmupFrames, int measuredFrames,
+	const std::string & json, const std::string & baseline, double tolerance)
+{
+	std::unique_ptr<BenchmarkScene> benchmarkScene = BenchmarkScene::Create(scene);
+	if (!benchmarkScene) {
+		std::cout << "Unknown scene " << scene << ", pick one of: " << BenchmarkScene::GetSceneNames() << std::endl;
+		return -1;
+	}
+
+	context.SetVSync(false);
+	FrameBenchmark benchmark(context, warmupFrames, measuredFrames);
+	benchmark.Run(*benchmarkScene);
+	if (!benchmark.WriteJSON(json))
+		return -1;
+
+	if (!baseline.empty() && !benchmark.CompareWithBaseline(baseline, tolerance))
+		return 1;
+	return 0;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+
+// standalone microbenchmarks, run from the command line (see main). They return the process exit code.
+
+/* legacy getline/stringstream parsing vs ShaderFile. Without a file a large multi-stage library is generated */
+int RunParserBenchmark(const char* filepath, int iterations);
+
+/* ACMR/ATVR and run time of MeshOptimizer's passes on generated meshes: a size x size grid, in scanline order and
+   shuffled, and a shuffled sphere */
+int RunMeshBenchmark(int size, int iterations);
+/* checks MeshOptimizer on the same meshes: the reordering passes keep the triangles and lower the shuffled ones' ACMR,
+   the vertex fetch remap keeps every corner on its vertex. Exit code 1 if something failed */
+int RunMeshTests(int size);
+
+/* RenderQueue's radix sort of count generated keys against std::stable_sort and std::sort, checking the radix sort
+   gives the same order as the stable one */
+int RunSortBenchmark(int count, int iterations);
+
+class GLContext;
+
+/* runs a BenchmarkScene with FrameBenchmark and writes the results as JSON (to stdout if json is empty). With a baseline
+   the exit code is 1 if frame times regressed by more than tolerance percent */
+int RunFrameBenchmark(GLContext& context, const std::string& scene, int warmupFrames, int measuredFrames,
+	const std::string& json, const std::string& baseline, double tolerance);
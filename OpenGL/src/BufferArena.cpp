@@ -0,0 +1,206 @@
+#include "BufferArena.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+#include "GLBuffer.h"
+#include <algorithm>
+
+namespace {
+
+	unsigned int AlignUp(unsigned int offset, unsigned int alignment)
+	{
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+}
+
+BufferArena::BufferArena(unsigned int blockSize)
+	: m_BlockSize(blockSize)
+{
+}
+
+BufferArena::~BufferArena()
+{
+	for (const Block& block : m_Blocks)
+		GLStateCache::Get().DeleteBuffer(block.buffer);
+}
+
+BufferArena::Block BufferArena::CreateBlock(unsigned int size)
+{
+	Block block;
+	block.size = std::max(size, m_BlockSize);
+	block.free[0] = block.size;
+
+	// GLBuffer doesn't disturb anything the state cache tracks
+	block.buffer = GLBuffer::CreateImmutable(block.size, nullptr, GL_STATIC_DRAW);
+	return block;
+}
+
+bool BufferArena::Allocate(unsigned int blockIndex, unsigned int size, unsigned int alignment, unsigned int & offset)
+{
+	Block& block = m_Blocks[blockIndex];
+	for (auto it = block.free.begin(); it != block.free.end(); ++it) {
+		unsigned int start = it->first, end = it->first + it->second;
+		unsigned int aligned = AlignUp(start, alignment);
+		if (aligned + size > end)
+			continue;
+
+		// what's left either side of the allocation stays free
+		block.free.erase(it);
+		if (aligned > start)
+			block.free[start] = aligned - start;
+		if (aligned + size < end)
+			block.free[aligned + size] = end - (aligned + size);
+		offset = aligned;
+		return true;
+	}
+	return false;
+}
+
+void BufferArena::Release(Block & block, unsigned int offset, unsigned int size)
+{
+	auto it = block.free.emplace(offset, size).first;
+
+	auto next = std::next(it);
+	if (next != block.free.end() && it->first + it->second == next->first) {
+		it->second += next->second;
+		block.free.erase(next);
+	}
+	if (it != block.free.begin()) {
+		auto previous = std::prev(it);
+		if (previous->first + previous->second == it->first) {
+			previous->second += it->second;
+			block.free.erase(it);
+		}
+	}
+}
+
+unsigned int BufferArena::Allocate(unsigned int size, unsigned int alignment, const void * data)
+{
+	ASSERT(alignment > 0);
+	if (0 == size)
+		return Invalid;
+
+	Record record = { 0, 0, size, alignment, true };
+	bool found = false;
+	for (unsigned int i = 0; i < m_Blocks.size() && !found; i++) {
+		if (Allocate(i, size, alignment, record.offset)) {
+			record.block = i;
+			found = true;
+		}
+	}
+	if (!found) {
+		m_Blocks.push_back(CreateBlock(size));
+		record.block = (unsigned int)m_Blocks.size() - 1;
+		Allocate(record.block, size, alignment, record.offset);
+	}
+
+	unsigned int handle;
+	if (m_FreeHandles.empty()) {
+		handle = (unsigned int)m_Records.size();
+		m_Records.push_back(record);
+	}
+	else {
+		handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+		m_Records[handle] = record;
+	}
+
+	if (data)
+		SetData(handle, data, size);
+	return handle;
+}
+
+void BufferArena::Free(unsigned int handle)
+{
+	if (Invalid == handle)
+		return;
+
+	Record& record = m_Records[handle];
+	ASSERT(record.live);
+	Release(m_Blocks[record.block], record.offset, record.size);
+	record.live = false;
+	m_FreeHandles.push_back(handle);
+}
+
+BufferArena::Allocation BufferArena::Get(unsigned int handle) const
+{
+	const Record& record = m_Records[handle];
+	ASSERT(record.live);
+	Allocation allocation = { m_Blocks[record.block].buffer, record.offset, record.size };
+	return allocation;
+}
+
+void BufferArena::SetData(unsigned int handle, const void * data, unsigned int size, unsigned int offset)
+{
+	const Record& record = m_Records[handle];
+	ASSERT(record.live && offset + size <= record.size);
+	GLBuffer::SetSubData(m_Blocks[record.block].buffer, record.offset + offset, size, data);
+}
+
+unsigned int BufferArena::Defragment()
+{
+	std::vector<unsigned int> handles;
+	for (unsigned int i = 0; i < m_Records.size(); i++) {
+		if (m_Records[i].live)
+			handles.push_back(i);
+	}
+	// in the order they are now, so allocations made together stay together
+	std::sort(handles.begin(), handles.end(), [this](unsigned int a, unsigned int b) {
+		const Record& ra = m_Records[a];
+		const Record& rb = m_Records[b];
+		return ra.block != rb.block ? ra.block < rb.block : ra.offset < rb.offset;
+	});
+
+	// everything is copied front to back into fresh blocks (a copy within one buffer fails if the ranges overlap),
+	// starting a new block when the current one is full
+	unsigned int moved = 0;
+	std::vector<Block> blocks;
+	unsigned int offset = 0;
+	for (unsigned int handle : handles) {
+		Record& record = m_Records[handle];
+		unsigned int aligned = AlignUp(offset, record.alignment);
+		if (blocks.empty() || aligned + record.size > blocks.back().size) {
+			if (!blocks.empty() && offset < blocks.back().size)
+				blocks.back().free[offset] = blocks.back().size - offset;
+			blocks.push_back(CreateBlock(record.size));
+			blocks.back().free.clear();
+			offset = aligned = 0;
+		}
+		Block& block = blocks.back();
+		if (aligned > offset)
+			block.free[offset] = aligned - offset;		// padding
+
+		GLBuffer::Copy(m_Blocks[record.block].buffer, record.offset, block.buffer, aligned, record.size);
+
+		unsigned int blockIndex = (unsigned int)blocks.size() - 1;
+		if (record.block != blockIndex || record.offset != aligned)
+			moved++;
+		record.block = blockIndex;
+		record.offset = aligned;
+		offset = aligned + record.size;
+	}
+	if (!blocks.empty() && offset < blocks.back().size)
+		blocks.back().free[offset] = blocks.back().size - offset;
+
+	for (const Block& block : m_Blocks)
+		GLStateCache::Get().DeleteBuffer(block.buffer);
+	m_Blocks.swap(blocks);
+	return moved;
+}
+
+BufferArenaStats BufferArena::GetStats() const
+{
+	BufferArenaStats stats = { (unsigned int)m_Blocks.size(), 0, 0, 0, 0, 0 };
+	for (const Record& record : m_Records) {
+		if (record.live) {
+			stats.allocations++;
+			stats.used += record.size;
+		}
+	}
+	for (const Block& block : m_Blocks) {
+		stats.reserved += block.size;
+		stats.freeRanges += (unsigned int)block.free.size();
+		for (const auto& range : block.free)
+			stats.largestFree = std::max(stats.largestFree, range.second);
+	}
+	return stats;
+}
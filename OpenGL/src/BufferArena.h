@@ -0,0 +1,76 @@
+#pragma once
+#include <map>
+#include <vector>
+
+struct BufferArenaStats {
+	unsigned int blocks;			// GL buffers
+	unsigned int allocations;
+	unsigned int reserved;			// bytes in all blocks
+	unsigned int used;				// bytes handed out (without alignment padding)
+	unsigned int freeRanges;
+	unsigned int largestFree;		// biggest single allocation that fits without a new block
+};
+
+// hands out pieces of a few big GL buffers (blocks) instead of a buffer object per mesh: fewer objects for the driver
+// to track and fewer binds, since everything in a block binds as one buffer. Each block keeps a free list ordered by
+// offset, first fit, neighbouring free ranges are merged when freed. A request that fits no block gets a new one.
+// Vertex and index data can share an arena (GL doesn't mind what a buffer is bound as). VertexBuffer and IndexBuffer
+// have constructors that make them views into an arena.
+// Allocations are referred to by handle, Get() returns where one is now: Defragment() moves them, after that anything
+// that stored an offset (a vertex array made over a view) has to be made again.
+class BufferArena
+{
+public:
+	static const unsigned int Invalid = 0xFFFFFFFF;		// handle of a failed allocation
+
+	struct Allocation {
+		unsigned int buffer;		// opengl id of its block
+		unsigned int offset;		// bytes
+		unsigned int size;
+	};
+
+private:
+	struct Block {
+		unsigned int buffer;
+		unsigned int size;
+		std::map<unsigned int, unsigned int> free;		// offset -> size
+	};
+
+	struct Record {
+		unsigned int block;
+		unsigned int offset;
+		unsigned int size;
+		unsigned int alignment;
+		bool live;
+	};
+
+	unsigned int m_BlockSize;
+	std::vector<Block> m_Blocks;
+	std::vector<Record> m_Records;			// indexed by handle
+	std::vector<unsigned int> m_FreeHandles;
+
+	Block CreateBlock(unsigned int size);
+	/* first fit in one block, false if it doesn't fit */
+	bool Allocate(unsigned int blockIndex, unsigned int size, unsigned int alignment, unsigned int& offset);
+	/* puts a range back on the block's free list, merged with its neighbours */
+	void Release(Block& block, unsigned int offset, unsigned int size);
+
+public:
+	/* blockSize: bytes per GL buffer, bigger allocations get a block of their own */
+	BufferArena(unsigned int blockSize = 16 * 1024 * 1024);
+	~BufferArena();
+
+	/* alignment in bytes, any value (not just powers of two): use the vertex size for offsets usable as a base vertex.
+	   data (size bytes) is uploaded if it isn't nullptr. Returns a handle, or Invalid for a size of 0 */
+	unsigned int Allocate(unsigned int size, unsigned int alignment = 4, const void* data = nullptr);
+	void Free(unsigned int handle);
+	Allocation Get(unsigned int handle) const;
+	/* writes size bytes at offset into the allocation */
+	void SetData(unsigned int handle, const void* data, unsigned int size, unsigned int offset = 0);
+
+	/* packs all allocations into as few blocks as they fit in, copying on the GPU into fresh buffers (so buffer ids
+	   change too), and gives the rest back. Returns the number of allocations that moved */
+	unsigned int Defragment();
+
+	BufferArenaStats GetStats() const;
+};
@@ -0,0 +1,259 @@
+#include "FrameBenchmark.h"
+#include "BenchmarkScene.h"
+#include "GLContext.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double Milliseconds(Clock::time_point start, Clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	/* nearest rank, samples is sorted */
+	double Percentile(const std::vector<double>& samples, double percentile)
+	{
+		if (samples.empty())
+			return 0.0;
+		size_t rank = (size_t)(percentile / 100.0 * samples.size() + 0.5);
+		return samples[std::min(std::max(rank, (size_t)1), samples.size()) - 1];
+	}
+
+	void WriteStats(std::ostream& out, const char* name, std::vector<double> samples)
+	{
+		std::sort(samples.begin(), samples.end());
+		double sum = 0.0;
+		for (double sample : samples)
+			sum += sample;
+
+		out << "\t\"" << name << "_mean\": " << (samples.empty() ? 0.0 : sum / samples.size()) << ",\n";
+		out << "\t\"" << name << "_p50\": " << Percentile(samples, 50.0) << ",\n";
+		out << "\t\"" << name << "_p95\": " << Percentile(samples, 95.0) << ",\n";
+		out << "\t\"" << name << "_p99\": " << Percentile(samples, 99.0) << ",\n";
+	}
+
+	std::string Escape(const char* text)
+	{
+		std::string escaped;
+		for (const char* c = text; c && *c; c++) {
+			if ('"' == *c || '\\' == *c)
+				escaped += '\\';
+			escaped += *c;
+		}
+		return escaped;
+	}
+
+	/* finds "key": number in our own flat JSON, false if it isn't there */
+	bool FindValue(const std::string& json, const std::string& key, double& value)
+	{
+		size_t at = json.find("\"" + key + "\":");
+		if (std::string::npos == at)
+			return false;
+		value = strtod(json.c_str() + at + key.size() + 3, nullptr);
+		return true;
+	}
+}
+
+FrameBenchmark::FrameBenchmark(GLContext & context, int warmupFrames, int measuredFrames)
+	: m_Context(context), m_WarmupFrames(warmupFrames), m_MeasuredFrames(measuredFrames), m_LastTimestamp(0),
+	m_GpuDropped(0), m_Draws(0), m_Triangles(0), m_Uploaded(0), m_Stalls(0), m_StateChanges(0), m_StateElided(0), m_Seconds(0.0)
+{
+	for (auto& slot : m_Queries) {
+		GLCall(glGenQueries(1, &slot.elapsed));
+		GLCall(glGenQueries(1, &slot.timestamp));
+		slot.pending = false;
+		slot.measured = false;
+	}
+}
+
+FrameBenchmark::~FrameBenchmark()
+{
+	for (auto& slot : m_Queries) {
+		GLCall(glDeleteQueries(1, &slot.elapsed));
+		GLCall(glDeleteQueries(1, &slot.timestamp));
+	}
+}
+
+void FrameBenchmark::ReadQuery(QuerySlot & slot, bool wait)
+{
+	slot.pending = false;
+
+	// the timestamp comes after the elapsed query ends, if it's there so is the other one
+	if (!wait) {
+		GLint available = 0;
+		GLCall(glGetQueryObjectiv(slot.timestamp, GL_QUERY_RESULT_AVAILABLE, &available));
+		if (!available) {
+			if (slot.measured)
+				m_GpuDropped++;
+			m_LastTimestamp = 0;
+			return;
+		}
+	}
+
+	GLuint64 elapsed, timestamp;
+	GLCall(glGetQueryObjectui64v(slot.elapsed, GL_QUERY_RESULT, &elapsed));
+	GLCall(glGetQueryObjectui64v(slot.timestamp, GL_QUERY_RESULT, &timestamp));
+	if (slot.measured) {
+		m_Gpu.push_back(elapsed / 1e6);
+		if (m_LastTimestamp)
+			m_GpuInterval.push_back((timestamp - m_LastTimestamp) / 1e6);
+	}
+	m_LastTimestamp = timestamp;
+}
+
+void FrameBenchmark::Run(BenchmarkScene & scene)
+{
+	m_SceneName = scene.GetName();
+	m_Update.clear();
+	m_Submit.clear();
+	m_Swap.clear();
+	m_Frame.clear();
+	m_Gpu.clear();
+	m_GpuInterval.clear();
+	m_GpuDropped = 0;
+	m_Draws = m_Triangles = m_Uploaded = m_Stalls = 0;
+	m_StateChanges = m_StateElided = 0;
+	m_Seconds = 0.0;
+	m_LastTimestamp = 0;
+	m_Counters.clear();
+
+	int frames = m_WarmupFrames + m_MeasuredFrames;
+	for (int frame = 0; frame < frames; frame++) {
+		bool measured = frame >= m_WarmupFrames;
+
+		// the slot was last used QueryLatency frames ago, its results are most likely in by now
+		QuerySlot& slot = m_Queries[frame % QueryLatency];
+		if (slot.pending)
+			ReadQuery(slot, false);
+
+		Clock::time_point start = Clock::now();
+		scene.Update(frame);
+		Clock::time_point updated = Clock::now();
+
+		GLCall(glBeginQuery(GL_TIME_ELAPSED, slot.elapsed));
+		GLStateCache::Get().ResetStats();
+		SceneStats stats = scene.Submit();
+		const GLStateStats state = GLStateCache::Get().GetStats();
+		GLCall(glEndQuery(GL_TIME_ELAPSED));
+		Clock::time_point submitted = Clock::now();
+
+		m_Context.SwapBuffers();
+		m_Context.PollEvents();
+		GLCall(glQueryCounter(slot.timestamp, GL_TIMESTAMP));
+		Clock::time_point swapped = Clock::now();
+
+		slot.pending = true;
+		slot.measured = measured;
+		if (measured) {
+			m_Update.push_back(Milliseconds(start, updated));
+			m_Submit.push_back(Milliseconds(updated, submitted));
+			m_Swap.push_back(Milliseconds(submitted, swapped));
+			m_Frame.push_back(Milliseconds(start, swapped));
+			m_Seconds += m_Frame.back() / 1000.0;
+			m_Draws += stats.draws;
+			m_Triangles += stats.triangles;
+			m_Uploaded += stats.uploaded;
+			m_Stalls += stats.stalls;
+			m_StateChanges += state.issued;
+			m_StateElided += state.elided;
+		}
+	}
+
+	// the run is over, waiting costs nothing now - oldest first so the intervals line up
+	for (int i = 0; i < (int)QueryLatency; i++) {
+		QuerySlot& slot = m_Queries[(frames + i) % QueryLatency];
+		if (slot.pending)
+			ReadQuery(slot, true);
+	}
+	m_Counters = scene.GetCounters();
+}
+
+bool FrameBenchmark::WriteJSON(const std::string & filepath) const
+{
+	std::ostringstream out;
+	out << "{\n";
+	out << "\t\"scene\": \"" << Escape(m_SceneName.c_str()) << "\",\n";
+	out << "\t\"renderer\": \"" << Escape((const char*)glGetString(GL_RENDERER)) << "\",\n";
+	out << "\t\"headless\": " << (m_Context.IsHeadless() ? "true" : "false") << ",\n";
+	out << "\t\"warmup_frames\": " << m_WarmupFrames << ",\n";
+	out << "\t\"frames\": " << m_MeasuredFrames << ",\n";
+	out << "\t\"fps\": " << (m_Seconds > 0.0 ? m_MeasuredFrames / m_Seconds : 0.0) << ",\n";
+	out << "\t\"draws_per_sec\": " << (m_Seconds > 0.0 ? m_Draws / m_Seconds : 0.0) << ",\n";
+	out << "\t\"triangles_per_sec\": " << (m_Seconds > 0.0 ? m_Triangles / m_Seconds : 0.0) << ",\n";
+	out << "\t\"upload_mb_per_sec\": " << (m_Seconds > 0.0 ? m_Uploaded / (1024.0 * 1024.0) / m_Seconds : 0.0) << ",\n";
+	out << "\t\"stalls\": " << m_Stalls << ",\n";
+	out << "\t\"state_changes_per_frame\": " << (m_MeasuredFrames > 0 ? (double)m_StateChanges / m_MeasuredFrames : 0.0) << ",\n";
+	out << "\t\"state_changes_elided_per_frame\": " << (m_MeasuredFrames > 0 ? (double)m_StateElided / m_MeasuredFrames : 0.0) << ",\n";
+	for (const auto& counter : m_Counters)
+		out << "\t\"" << Escape(counter.first.c_str()) << "\": " << counter.second << ",\n";
+	WriteStats(out, "cpu_update_ms", m_Update);
+	WriteStats(out, "cpu_submit_ms", m_Submit);
+	WriteStats(out, "cpu_swap_ms", m_Swap);
+	WriteStats(out, "cpu_frame_ms", m_Frame);
+	WriteStats(out, "gpu_ms", m_Gpu);
+	WriteStats(out, "gpu_frame_interval_ms", m_GpuInterval);
+	out << "\t\"gpu_dropped\": " << m_GpuDropped << "\n";
+	out << "}\n";
+
+	if (filepath.empty()) {
+		std::cout << out.str();
+		return true;
+	}
+
+	std::ofstream file(filepath, std::ios::trunc);
+	if (!file) {
+		std::cout << "Can't write " << filepath << std::endl;
+		return false;
+	}
+	file << out.str();
+	return true;
+}
+
+bool FrameBenchmark::CompareWithBaseline(const std::string & filepath, double tolerance) const
+{
+	std::ifstream file(filepath);
+	if (!file) {
+		std::cout << "Can't read baseline " << filepath << std::endl;
+		return false;
+	}
+	std::stringstream json;
+	json << file.rdbuf();
+
+	std::vector<double> frame(m_Frame), gpu(m_Gpu);
+	std::sort(frame.begin(), frame.end());
+	std::sort(gpu.begin(), gpu.end());
+
+	// p99 is reported but too noisy to fail a run on, and so is any change of a few microseconds
+	const double NoiseFloor = 0.01;
+	struct Metric { const char* key; double value; bool gates; };
+	const Metric metrics[] = {
+		{ "cpu_frame_ms_p50", Percentile(frame, 50.0), true },
+		{ "cpu_frame_ms_p95", Percentile(frame, 95.0), true },
+		{ "cpu_frame_ms_p99", Percentile(frame, 99.0), false },
+		{ "gpu_ms_p50", Percentile(gpu, 50.0), true },
+		{ "gpu_ms_p95", Percentile(gpu, 95.0), true },
+	};
+
+	bool passed = true;
+	for (const Metric& metric : metrics) {
+		double before, after = metric.value;
+		if (!FindValue(json.str(), metric.key, before) || before <= 0.0 || after <= 0.0)
+			continue;
+
+		double change = (after - before) / before * 100.0;
+		bool regressed = metric.gates && change > tolerance && after - before > NoiseFloor;
+		std::cout << metric.key << ": " << before << " -> " << after << " (" << (change >= 0.0 ? "+" : "") << change << "%)"
+			<< (regressed ? " REGRESSION" : "") << std::endl;
+		passed = passed && !regressed;
+	}
+	return passed;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+
+class GLContext;
+class BenchmarkScene;
+
+// runs a scene for a number of warmup frames and then measured ones, timing each frame's phases on the CPU (update,
+// submit, swap) and the GPU work with GL_TIME_ELAPSED / GL_TIMESTAMP queries. The queries go round a ring a few
+// frames deep and are only read once their result is available, so timing never stalls the pipeline - a result
+// that still isn't there when its slot comes round again is dropped (and counted). Results are written as flat JSON
+// so runs can be compared by a script, or against a baseline file with CompareWithBaseline().
+class FrameBenchmark
+{
+private:
+	static const unsigned int QueryLatency = 4;		// frames a query result may lag behind
+
+	struct QuerySlot {
+		unsigned int elapsed;		// GL_TIME_ELAPSED around the frame's submit
+		unsigned int timestamp;		// GL_TIMESTAMP after the swap
+		bool pending;				// issued and not read yet
+		bool measured;				// issued in a measured frame (not a warmup one)
+	};
+
+	GLContext& m_Context;
+	int m_WarmupFrames;
+	int m_MeasuredFrames;
+	QuerySlot m_Queries[QueryLatency];
+	unsigned long long m_LastTimestamp;		// of the previous frame read, 0 if that one was dropped
+
+	std::string m_SceneName;
+	std::vector<double> m_Update, m_Submit, m_Swap, m_Frame;	// CPU, ms per measured frame
+	std::vector<double> m_Gpu, m_GpuInterval;					// GPU, ms
+	unsigned int m_GpuDropped;
+	unsigned long long m_Draws;
+	unsigned long long m_Triangles;
+	unsigned long long m_Uploaded;		// bytes
+	unsigned long long m_Stalls;		// SceneStats::stalls
+	unsigned long long m_StateChanges;	// GLStateCache calls during submit that reached the driver
+	unsigned long long m_StateElided;	// and those it dropped as redundant
+	double m_Seconds;					// wall time of the measured frames
+	std::vector<std::pair<std::string, double>> m_Counters;		// BenchmarkScene::GetCounters
+
+	/* wait: block until the result is there (only once the run is over) */
+	void ReadQuery(QuerySlot& slot, bool wait);
+
+public:
+	FrameBenchmark(GLContext& context, int warmupFrames, int measuredFrames);
+	~FrameBenchmark();
+
+	void Run(BenchmarkScene& scene);
+
+	/* to stdout if filepath is empty */
+	bool WriteJSON(const std::string& filepath) const;
+	/* compares frame time percentiles against a previous run's JSON, false if one got worse by more than tolerance
+	   (a percentage) and by more than 0.01ms */
+	bool CompareWithBaseline(const std::string& filepath, double tolerance) const;
+};
@@ -0,0 +1,104 @@
+#include "GLBuffer.h"
+#include "Renderer.h"
+
+bool GLBuffer::HasDirectStateAccess()
+{
+	return GLEW_VERSION_4_5 || GLEW_ARB_direct_state_access;
+}
+
+unsigned int GLBuffer::Create(unsigned int size, const void * data, unsigned int usage)
+{
+	unsigned int buffer;
+	if (HasDirectStateAccess()) {
+		GLCall(glCreateBuffers(1, &buffer));
+		GLCall(glNamedBufferData(buffer, size, data, usage));
+		return buffer;
+	}
+
+	// a name from glGenBuffers only becomes a buffer once it's bound
+	GLCall(glGenBuffers(1, &buffer));
+	GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer));
+	GLCall(glBufferData(GL_COPY_WRITE_BUFFER, size, data, usage));
+	return buffer;
+}
+
+unsigned int GLBuffer::CreateImmutable(unsigned int size, const void * data, unsigned int usage)
+{
+	if (HasDirectStateAccess())
+		return CreateStorage(size, data, GL_DYNAMIC_STORAGE_BIT);
+	return Create(size, data, usage);
+}
+
+unsigned int GLBuffer::CreateStorage(unsigned int size, const void * data, unsigned int flags)
+{
+	unsigned int buffer;
+	if (HasDirectStateAccess()) {
+		GLCall(glCreateBuffers(1, &buffer));
+		GLCall(glNamedBufferStorage(buffer, size, data, flags));
+		return buffer;
+	}
+
+	GLCall(glGenBuffers(1, &buffer));
+	GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer));
+	GLCall(glBufferStorage(GL_COPY_WRITE_BUFFER, size, data, flags));
+	return buffer;
+}
+
+void GLBuffer::SetData(unsigned int buffer, unsigned int size, const void * data, unsigned int usage)
+{
+	if (HasDirectStateAccess()) {
+		GLCall(glNamedBufferData(buffer, size, data, usage));
+		return;
+	}
+
+	GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer));
+	GLCall(glBufferData(GL_COPY_WRITE_BUFFER, size, data, usage));
+}
+
+void GLBuffer::SetSubData(unsigned int buffer, unsigned int offset, unsigned int size, const void * data)
+{
+	if (HasDirectStateAccess()) {
+		GLCall(glNamedBufferSubData(buffer, offset, size, data));
+		return;
+	}
+
+	GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer));
+	GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data));
+}
+
+void GLBuffer::Copy(unsigned int source, unsigned int sourceOffset, unsigned int destination, unsigned int destinationOffset,
+	unsigned int size)
+{
+	if (HasDirectStateAccess()) {
+		GLCall(glCopyNamedBufferSubData(source, destination, sourceOffset, destinationOffset, size));
+		return;
+	}
+
+	GLCall(glBindBuffer(GL_COPY_READ_BUFFER, source));
+	GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, destination));
+	GLCall(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, destinationOffset, size));
+}
+
+void * GLBuffer::Map(unsigned int buffer, unsigned int offset, unsigned int size, unsigned int access)
+{
+	void* memory;
+	if (HasDirectStateAccess()) {
+		GLCall(memory = glMapNamedBufferRange(buffer, offset, size, access));
+		return memory;
+	}
+
+	GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer));
+	GLCall(memory = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, access));
+	return memory;
+}
+
+void GLBuffer::Unmap(unsigned int buffer)
+{
+	if (HasDirectStateAccess()) {
+		GLCall(glUnmapNamedBuffer(buffer));
+		return;
+	}
+
+	GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer));
+	GLCall(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+// buffer creation and uploads that never touch a binding the renderer draws with. With direct state access (GL 4.5 or
+// ARB_direct_state_access) they're glCreateBuffers and glNamedBuffer*, no binding at all. Otherwise the buffer is
+// bound to GL_COPY_WRITE_BUFFER to edit it, which nothing draws from and the state cache doesn't track.
+// Sizes and offsets are in bytes.
+class GLBuffer
+{
+public:
+	static bool HasDirectStateAccess();
+
+	/* storage that can be reallocated (orphaned) with SetData. usage: GL_STATIC_DRAW, GL_DYNAMIC_DRAW... */
+	static unsigned int Create(unsigned int size, const void* data, unsigned int usage);
+	/* for buffers that never change size: immutable storage with direct state access (glNamedBufferStorage, still
+	   writable with SetSubData), the same as Create otherwise */
+	static unsigned int CreateImmutable(unsigned int size, const void* data, unsigned int usage);
+	/* glBufferStorage with flags (GL_MAP_PERSISTENT_BIT...), needs GL 4.4 or ARB_buffer_storage */
+	static unsigned int CreateStorage(unsigned int size, const void* data, unsigned int flags);
+
+	/* reallocates the buffer with size bytes of data (nullptr orphans it). Not for immutable storage */
+	static void SetData(unsigned int buffer, unsigned int size, const void* data, unsigned int usage);
+	static void SetSubData(unsigned int buffer, unsigned int offset, unsigned int size, const void* data);
+	static void Copy(unsigned int source, unsigned int sourceOffset, unsigned int destination, unsigned int destinationOffset,
+		unsigned int size);
+
+	static void* Map(unsigned int buffer, unsigned int offset, unsigned int size, unsigned int access);
+	static void Unmap(unsigned int buffer);
+};
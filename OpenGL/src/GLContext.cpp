@@ -0,0 +1,56 @@
+#include "GLContext.h"
+#include "HeadlessContext.h"
+#include "WindowContext.h"
+#include "Renderer.h"
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+GLContext::GLContext(int width, int height)
+	: m_Width(width), m_Height(height)
+{
+}
+
+std::unique_ptr<GLContext> GLContext::Create(bool headless, int width, int height, const char * title)
+{
+	std::unique_ptr<GLContext> context;
+	if (headless)
+		context.reset(HeadlessContext::Create(width, height));
+	else
+		context.reset(WindowContext::Create(width, height, title));
+	if (!context)
+		return nullptr;
+
+	// glew loads through glXGetProcAddress on linux, which works for an EGL context too (both go through libglvnd) but
+	// then fails looking for a GLX display - the GL functions are loaded by then
+	GLenum error = glewInit();
+	if (GLEW_OK != error && !(headless && GLEW_ERROR_NO_GLX_DISPLAY == error)) {
+		std::cout << "GLEW Error! " << glewGetErrorString(error) << std::endl;
+		return nullptr;
+	}
+
+	std::cout << glGetString(GL_VERSION) << " (" << glGetString(GL_RENDERER) << ")" << std::endl;
+
+	if (!context->OnLoaded())
+		return nullptr;
+	return context;
+}
+
+bool GLContext::SaveFrame(const std::string & filepath) const
+{
+	std::vector<unsigned char> pixels(m_Width * m_Height * 3);
+	GLCall(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+	GLCall(glReadPixels(0, 0, m_Width, m_Height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data()));
+
+	std::ofstream file(filepath, std::ios::binary);
+	if (!file) {
+		std::cout << "Can't write " << filepath << std::endl;
+		return false;
+	}
+
+	// GL's first row is the bottom one
+	file << "P6\n" << m_Width << " " << m_Height << "\n255\n";
+	for (int y = m_Height - 1; y >= 0; y--)
+		file.write((const char*)&pixels[y * m_Width * 3], m_Width * 3);
+	return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <memory>
+#include <string>
+
+// what we render into: a window, or an offscreen framebuffer on machines without a display. Everything else (buffers,
+// vertex arrays, shaders) is the same either way.
+class GLContext
+{
+protected:
+	int m_Width;
+	int m_Height;
+
+	GLContext(int width, int height);
+
+	/* called once the context is current and GL functions are loaded */
+	virtual bool OnLoaded() { return true; }
+
+public:
+	virtual ~GLContext() {}
+
+	/* headless: an offscreen context (EGL surfaceless, or OSMesa), nothing is shown. Returns nullptr on failure */
+	static std::unique_ptr<GLContext> Create(bool headless, int width, int height, const char* title);
+
+	virtual bool IsHeadless() const = 0;
+	virtual bool ShouldClose() const = 0;
+	virtual void SwapBuffers() = 0;
+	virtual void PollEvents() = 0;
+	/* off for benchmarks, so frames aren't paced by the display */
+	virtual void SetVSync(bool enabled) = 0;
+
+	/* writes what was last rendered to a binary PPM */
+	bool SaveFrame(const std::string& filepath) const;
+
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+};
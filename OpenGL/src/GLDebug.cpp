@@ -0,0 +1,172 @@
+#include "GLDebug.h"
+#include "Renderer.h"
+#include <algorithm>
+#include <iostream>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <dbghelp.h>
+#pragma comment(lib, "dbghelp.lib")
+#elif defined(__linux__)
+#include <execinfo.h>
+#include <unistd.h>
+#endif
+
+bool GLDebug::s_Active = false;
+bool GLDebug::s_Reliable = false;
+bool GLDebug::s_BreakOnError = true;
+unsigned int GLDebug::s_ErrorCount = 0;
+std::vector<unsigned int> GLDebug::s_IgnoredIds;
+
+namespace {
+
+	const char* GetSourceName(GLenum source)
+	{
+		switch (source)
+		{
+			case GL_DEBUG_SOURCE_API:				return "api";
+			case GL_DEBUG_SOURCE_WINDOW_SYSTEM:		return "window system";
+			case GL_DEBUG_SOURCE_SHADER_COMPILER:	return "shader compiler";
+			case GL_DEBUG_SOURCE_THIRD_PARTY:		return "third party";
+			case GL_DEBUG_SOURCE_APPLICATION:		return "application";
+		}
+		return "other";
+	}
+
+	const char* GetTypeName(GLenum type)
+	{
+		switch (type)
+		{
+			case GL_DEBUG_TYPE_ERROR:				return "error";
+			case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:	return "deprecated";
+			case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:	return "undefined behaviour";
+			case GL_DEBUG_TYPE_PORTABILITY:			return "portability";
+			case GL_DEBUG_TYPE_PERFORMANCE:			return "performance";
+			case GL_DEBUG_TYPE_MARKER:				return "marker";
+		}
+		return "other";
+	}
+
+	const char* GetSeverityName(GLenum severity)
+	{
+		switch (severity)
+		{
+			case GL_DEBUG_SEVERITY_HIGH:			return "high";
+			case GL_DEBUG_SEVERITY_MEDIUM:			return "medium";
+			case GL_DEBUG_SEVERITY_LOW:				return "low";
+		}
+		return "notification";
+	}
+}
+
+// the GL callback, a friend of GLDebug so it can reach the private state
+struct GLDebugCallback {
+	static void GLAPIENTRY OnMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
+};
+
+void GLAPIENTRY GLDebugCallback::OnMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei /*length*/, const GLchar * message, const void * /*userParam*/)
+{
+	if (std::find(GLDebug::s_IgnoredIds.begin(), GLDebug::s_IgnoredIds.end(), id) != GLDebug::s_IgnoredIds.end())
+		return;
+
+	std::cout << "GL " << GetTypeName(type) << " (" << GetSourceName(source) << ", " << GetSeverityName(severity)
+		<< ", id " << id << "): " << message << std::endl;
+
+	if (GL_DEBUG_TYPE_ERROR == type) {
+		GLDebug::s_ErrorCount++;
+		GLDebug::PrintBacktrace();
+		if (GLDebug::s_BreakOnError)
+			ASSERT(false);
+	}
+}
+
+void GLDebug::PrintBacktrace()
+{
+	const int MaxFrames = 32;
+	void* frames[MaxFrames];
+#if defined(_WIN32)
+	static bool symbolsLoaded = false;
+	HANDLE process = GetCurrentProcess();
+	if (!symbolsLoaded) {
+		SymInitialize(process, nullptr, TRUE);
+		symbolsLoaded = true;
+	}
+
+	unsigned short count = CaptureStackBackTrace(2, MaxFrames, frames, nullptr);	// skip ourselves and the callback
+	char buffer[sizeof(SYMBOL_INFO) + 256];
+	SYMBOL_INFO* symbol = (SYMBOL_INFO*)buffer;
+	symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+	symbol->MaxNameLen = 255;
+	for (unsigned short i = 0; i < count; i++) {
+		if (SymFromAddr(process, (DWORD64)frames[i], nullptr, symbol))
+			std::cout << "  " << symbol->Name << std::endl;
+		else
+			std::cout << "  " << frames[i] << std::endl;
+	}
+#elif defined(__linux__)
+	int count = backtrace(frames, MaxFrames);
+	std::cout.flush();
+	backtrace_symbols_fd(frames + 2, count - 2, STDOUT_FILENO);		// skip ourselves and the callback
+#else
+	(void)frames;
+#endif
+}
+
+bool GLDebug::Enable(bool synchronous)
+{
+	if (!GLEW_VERSION_4_3 && !GLEW_KHR_debug) {
+		std::cout << "KHR_debug unavailable, checking for GL errors with glGetError" << std::endl;
+		return false;
+	}
+
+	GLCall(glEnable(GL_DEBUG_OUTPUT));
+	if (synchronous) {
+		GLCall(glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
+	}
+	GLCall(glDebugMessageCallback(GLDebugCallback::OnMessage, nullptr));
+	SetMinimumSeverity(GL_DEBUG_SEVERITY_LOW);	// notifications are mostly "buffer uses video memory"
+	s_Active = true;
+
+	int flags = 0;
+	GLCall(glGetIntegerv(GL_CONTEXT_FLAGS, &flags));
+	s_Reliable = (flags & GL_CONTEXT_FLAG_DEBUG_BIT) != 0;
+	if (!s_Reliable)
+		std::cout << "Not a debug context, still checking for GL errors with glGetError" << std::endl;
+	return true;
+}
+
+void GLDebug::Disable()
+{
+	if (!s_Active)
+		return;
+
+	s_Active = false;
+	s_Reliable = false;
+	GLCall(glDebugMessageCallback(nullptr, nullptr));
+	GLCall(glDisable(GL_DEBUG_OUTPUT));
+}
+
+void GLDebug::SetMinimumSeverity(unsigned int severity)
+{
+	const GLenum severities[] = { GL_DEBUG_SEVERITY_HIGH, GL_DEBUG_SEVERITY_MEDIUM, GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_NOTIFICATION };
+
+	bool enabled = true;
+	for (GLenum current : severities) {
+		GLCall(glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, current, 0, nullptr, enabled ? GL_TRUE : GL_FALSE));
+		if (current == severity)
+			enabled = false;	// everything after this one is less severe
+	}
+}
+
+void GLDebug::SetSourceEnabled(unsigned int source, bool enabled)
+{
+	GLCall(glDebugMessageControl(source, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, enabled ? GL_TRUE : GL_FALSE));
+}
+
+void GLDebug::IgnoreId(unsigned int id)
+{
+	// filtered here rather than with glDebugMessageControl, which needs the message's source and type as well
+	if (std::find(s_IgnoredIds.begin(), s_IgnoredIds.end(), id) == s_IgnoredIds.end())
+		s_IgnoredIds.push_back(id);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+
+// reports GL errors through a KHR_debug message callback instead of polling glGetError around every call. Once the
+// callback is installed in a debug context (GL_CONTEXT_FLAG_DEBUG_BIT) GLCall stops calling glGetError, so debug
+// builds run at close to release speed. Outside a debug context the driver doesn't have to send anything, so the
+// callback only adds to glGetError there. With
+// synchronous output the callback runs inside the offending call, so the backtrace (and the debugger) points at it.
+// Without KHR_debug (or GL 4.3) nothing changes and GLCall keeps using glGetError.
+class GLDebug
+{
+private:
+	static bool s_Active;
+	static bool s_Reliable;				// the context has GL_CONTEXT_FLAG_DEBUG_BIT, errors always reach the callback
+	static bool s_BreakOnError;
+	static unsigned int s_ErrorCount;
+	static std::vector<unsigned int> s_IgnoredIds;
+
+	static void PrintBacktrace();
+
+	friend struct GLDebugCallback;
+
+public:
+	/* call once the context is current, returns false if KHR_debug isn't available */
+	static bool Enable(bool synchronous = true);
+	static void Disable();
+	static inline bool IsActive() { return s_Active; }
+	/* the callback is sure to see every error, glGetError can be skipped */
+	static inline bool ReportsErrors() { return s_Active && s_Reliable; }
+
+	/* severity is GL_DEBUG_SEVERITY_HIGH/MEDIUM/LOW/NOTIFICATION, anything less severe is dropped by the driver */
+	static void SetMinimumSeverity(unsigned int severity);
+	/* source is a GL_DEBUG_SOURCE_* value */
+	static void SetSourceEnabled(unsigned int source, bool enabled);
+	/* drops a message by id, e.g. driver notifications that repeat every frame */
+	static void IgnoreId(unsigned int id);
+	/* errors trigger ASSERT by default, warnings never do */
+	static inline void SetBreakOnError(bool enabled) { s_BreakOnError = enabled; }
+
+	static inline unsigned int GetErrorCount() { return s_ErrorCount; }
+};
@@ -0,0 +1,380 @@
+#include "GLStateCache.h"
+#include "Renderer.h"
+#include <iostream>
+
+namespace {
+
+	int GetTargetIndex(unsigned int target)
+	{
+		switch (target)
+		{
+			case GL_TEXTURE_2D:			return 0;
+			case GL_TEXTURE_2D_ARRAY:	return 1;
+			case GL_TEXTURE_3D:			return 2;
+			case GL_TEXTURE_CUBE_MAP:	return 3;
+		}
+		return -1;
+	}
+
+	unsigned int GetTargetBinding(unsigned int target)
+	{
+		switch (target)
+		{
+			case GL_TEXTURE_2D:			return GL_TEXTURE_BINDING_2D;
+			case GL_TEXTURE_2D_ARRAY:	return GL_TEXTURE_BINDING_2D_ARRAY;
+			case GL_TEXTURE_3D:			return GL_TEXTURE_BINDING_3D;
+			case GL_TEXTURE_CUBE_MAP:	return GL_TEXTURE_BINDING_CUBE_MAP;
+		}
+		return 0;
+	}
+}
+
+GLStateCache* GLStateCache::s_Current = nullptr;
+
+GLStateCache::GLStateCache()
+	: m_Validate(false)
+{
+	m_Stats.issued = 0;
+	m_Stats.elided = 0;
+	Invalidate();
+}
+
+GLStateCache & GLStateCache::Get()
+{
+	static GLStateCache defaultCache;
+	return s_Current ? *s_Current : defaultCache;
+}
+
+void GLStateCache::MakeCurrent(GLStateCache * cache)
+{
+	s_Current = cache;
+}
+
+void GLStateCache::Invalidate()
+{
+	m_Program = Unknown;
+	m_VertexArray = Unknown;
+	m_ArrayBuffer = Unknown;
+	m_ElementBuffers.clear();
+	m_ActiveTexture = Unknown;
+	for (auto& unit : m_Textures) {
+		for (auto& texture : unit)
+			texture = Unknown;
+	}
+	m_Blend = Unknown;
+	m_BlendSrc = m_BlendDst = Unknown;
+	m_DepthTest = Unknown;
+	m_DepthWrite = Unknown;
+	m_DepthFunc = Unknown;
+	m_PrimitiveRestart = Unknown;
+	m_RestartIndex = Unknown;
+	m_RestartIndexKnown = false;
+	m_ViewportKnown = false;
+}
+
+bool GLStateCache::Elide(bool unchanged)
+{
+	if (unchanged)
+		m_Stats.elided++;
+	else
+		m_Stats.issued++;
+	return unchanged;
+}
+
+void GLStateCache::Check(unsigned int pname, unsigned int expected, const char * what) const
+{
+	if (Unknown == expected)
+		return;
+
+	int actual;
+	GLCall(glGetIntegerv(pname, &actual));
+	if ((unsigned int)actual != expected) {
+		std::cout << "GL state cache out of sync: " << what << " is " << actual << ", cache says " << expected << std::endl;
+		ASSERT(false);
+	}
+}
+
+void GLStateCache::UseProgram(unsigned int program)
+{
+	if (m_Validate)
+		Check(GL_CURRENT_PROGRAM, m_Program, "program");
+	if (Elide(m_Program == program))
+		return;
+
+	GLCall(glUseProgram(program));
+	m_Program = program;
+}
+
+void GLStateCache::BindVertexArray(unsigned int vertexArray)
+{
+	if (m_Validate)
+		Check(GL_VERTEX_ARRAY_BINDING, m_VertexArray, "vertex array");
+	if (Elide(m_VertexArray == vertexArray))
+		return;
+
+	GLCall(glBindVertexArray(vertexArray));
+	m_VertexArray = vertexArray;
+}
+
+void GLStateCache::BindBuffer(unsigned int target, unsigned int buffer)
+{
+	if (GL_ARRAY_BUFFER == target) {
+		if (m_Validate)
+			Check(GL_ARRAY_BUFFER_BINDING, m_ArrayBuffer, "array buffer");
+		if (Elide(m_ArrayBuffer == buffer))
+			return;
+
+		GLCall(glBindBuffer(target, buffer));
+		m_ArrayBuffer = buffer;
+	}
+	else if (GL_ELEMENT_ARRAY_BUFFER == target) {
+		// binding an element buffer changes the bound vertex array, so look up what that one has
+		unsigned int current = Unknown;
+		if (Unknown != m_VertexArray) {
+			auto it = m_ElementBuffers.find(m_VertexArray);
+			if (it != m_ElementBuffers.end())
+				current = it->second;
+		}
+
+		if (m_Validate)
+			Check(GL_ELEMENT_ARRAY_BUFFER_BINDING, current, "element buffer");
+		if (Elide(current == buffer))
+			return;
+
+		GLCall(glBindBuffer(target, buffer));
+		if (Unknown != m_VertexArray)
+			m_ElementBuffers[m_VertexArray] = buffer;
+	}
+	else {
+		m_Stats.issued++;
+		GLCall(glBindBuffer(target, buffer));
+	}
+}
+
+void GLStateCache::SetElementBuffer(unsigned int vertexArray, unsigned int buffer)
+{
+	auto it = m_ElementBuffers.find(vertexArray);
+	unsigned int current = it != m_ElementBuffers.end() ? it->second : Unknown;
+	if (m_Validate && Unknown != current) {
+		int actual;
+		GLCall(glGetVertexArrayiv(vertexArray, GL_ELEMENT_ARRAY_BUFFER_BINDING, &actual));
+		if ((unsigned int)actual != current) {
+			std::cout << "GL state cache out of sync: element buffer of vertex array " << vertexArray << " is " << actual << ", cache says " << current << std::endl;
+			ASSERT(false);
+		}
+	}
+	if (Elide(current == buffer))
+		return;
+
+	GLCall(glVertexArrayElementBuffer(vertexArray, buffer));
+	m_ElementBuffers[vertexArray] = buffer;
+}
+
+void GLStateCache::BindTexture(unsigned int unit, unsigned int target, unsigned int texture)
+{
+	int index = GetTargetIndex(target);
+	if (unit >= MaxTextureUnits || -1 == index) {
+		m_Stats.issued += 2;
+		m_ActiveTexture = unit;
+		GLCall(glActiveTexture(GL_TEXTURE0 + unit));
+		GLCall(glBindTexture(target, texture));
+		return;
+	}
+
+	if (m_Validate) {
+		Check(GL_ACTIVE_TEXTURE, Unknown == m_ActiveTexture ? Unknown : GL_TEXTURE0 + m_ActiveTexture, "active texture");
+		if (m_ActiveTexture == unit)
+			Check(GetTargetBinding(target), m_Textures[unit][index], "texture");
+	}
+	if (Elide(m_Textures[unit][index] == texture))
+		return;
+
+	if (m_ActiveTexture != unit) {
+		m_Stats.issued++;
+		GLCall(glActiveTexture(GL_TEXTURE0 + unit));
+		m_ActiveTexture = unit;
+	}
+	GLCall(glBindTexture(target, texture));
+	m_Textures[unit][index] = texture;
+}
+
+void GLStateCache::SetBlend(bool enabled)
+{
+	if (m_Validate && Unknown != m_Blend) {
+		GLCall(bool actual = glIsEnabled(GL_BLEND) == GL_TRUE);
+		if (actual != (GL_TRUE == m_Blend)) {
+			std::cout << "GL state cache out of sync: blend" << std::endl;
+			ASSERT(false);
+		}
+	}
+	if (Elide(m_Blend == (enabled ? GL_TRUE : GL_FALSE)))
+		return;
+
+	if (enabled) {
+		GLCall(glEnable(GL_BLEND));
+	}
+	else {
+		GLCall(glDisable(GL_BLEND));
+	}
+	m_Blend = enabled ? GL_TRUE : GL_FALSE;
+}
+
+void GLStateCache::SetBlendFunc(unsigned int src, unsigned int dst)
+{
+	if (m_Validate) {
+		Check(GL_BLEND_SRC_RGB, m_BlendSrc, "blend source");
+		Check(GL_BLEND_DST_RGB, m_BlendDst, "blend destination");
+	}
+	if (Elide(m_BlendSrc == src && m_BlendDst == dst))
+		return;
+
+	GLCall(glBlendFunc(src, dst));
+	m_BlendSrc = src;
+	m_BlendDst = dst;
+}
+
+void GLStateCache::SetDepthTest(bool enabled)
+{
+	if (m_Validate && Unknown != m_DepthTest) {
+		GLCall(bool actual = glIsEnabled(GL_DEPTH_TEST) == GL_TRUE);
+		if (actual != (GL_TRUE == m_DepthTest)) {
+			std::cout << "GL state cache out of sync: depth test" << std::endl;
+			ASSERT(false);
+		}
+	}
+	if (Elide(m_DepthTest == (enabled ? GL_TRUE : GL_FALSE)))
+		return;
+
+	if (enabled) {
+		GLCall(glEnable(GL_DEPTH_TEST));
+	}
+	else {
+		GLCall(glDisable(GL_DEPTH_TEST));
+	}
+	m_DepthTest = enabled ? GL_TRUE : GL_FALSE;
+}
+
+void GLStateCache::SetDepthWrite(bool enabled)
+{
+	if (m_Validate)
+		Check(GL_DEPTH_WRITEMASK, m_DepthWrite, "depth write");
+	if (Elide(m_DepthWrite == (enabled ? GL_TRUE : GL_FALSE)))
+		return;
+
+	GLCall(glDepthMask(enabled ? GL_TRUE : GL_FALSE));
+	m_DepthWrite = enabled ? GL_TRUE : GL_FALSE;
+}
+
+void GLStateCache::SetDepthFunc(unsigned int func)
+{
+	if (m_Validate)
+		Check(GL_DEPTH_FUNC, m_DepthFunc, "depth function");
+	if (Elide(m_DepthFunc == func))
+		return;
+
+	GLCall(glDepthFunc(func));
+	m_DepthFunc = func;
+}
+
+void GLStateCache::SetPrimitiveRestart(bool enabled, unsigned int index)
+{
+	if (m_Validate && Unknown != m_PrimitiveRestart) {
+		GLCall(bool actual = glIsEnabled(GL_PRIMITIVE_RESTART) == GL_TRUE);
+		if (actual != (GL_TRUE == m_PrimitiveRestart)) {
+			std::cout << "GL state cache out of sync: primitive restart" << std::endl;
+			ASSERT(false);
+		}
+	}
+	if (m_Validate && enabled && m_RestartIndexKnown) {
+		int actual;
+		GLCall(glGetIntegerv(GL_PRIMITIVE_RESTART_INDEX, &actual));
+		if ((unsigned int)actual != m_RestartIndex) {
+			std::cout << "GL state cache out of sync: primitive restart index" << std::endl;
+			ASSERT(false);
+		}
+	}
+	bool indexSet = m_RestartIndexKnown && m_RestartIndex == index;
+	if (Elide(m_PrimitiveRestart == (enabled ? GL_TRUE : GL_FALSE) && (!enabled || indexSet)))
+		return;
+
+	if (enabled) {
+		if (!indexSet) {
+			GLCall(glPrimitiveRestartIndex(index));
+			m_RestartIndex = index;
+			m_RestartIndexKnown = true;
+		}
+		if (m_PrimitiveRestart != GL_TRUE) {
+			GLCall(glEnable(GL_PRIMITIVE_RESTART));
+		}
+	}
+	else {
+		GLCall(glDisable(GL_PRIMITIVE_RESTART));
+	}
+	m_PrimitiveRestart = enabled ? GL_TRUE : GL_FALSE;
+}
+
+void GLStateCache::SetViewport(int x, int y, int width, int height)
+{
+	if (m_Validate && m_ViewportKnown) {
+		int actual[4];
+		GLCall(glGetIntegerv(GL_VIEWPORT, actual));
+		if (actual[0] != m_Viewport[0] || actual[1] != m_Viewport[1] || actual[2] != m_Viewport[2] || actual[3] != m_Viewport[3]) {
+			std::cout << "GL state cache out of sync: viewport" << std::endl;
+			ASSERT(false);
+		}
+	}
+	if (Elide(m_ViewportKnown && m_Viewport[0] == x && m_Viewport[1] == y && m_Viewport[2] == width && m_Viewport[3] == height))
+		return;
+
+	GLCall(glViewport(x, y, width, height));
+	m_Viewport[0] = x;
+	m_Viewport[1] = y;
+	m_Viewport[2] = width;
+	m_Viewport[3] = height;
+	m_ViewportKnown = true;
+}
+
+void GLStateCache::DeleteProgram(unsigned int program)
+{
+	GLCall(glDeleteProgram(program));
+	// a program deleted while in use stays current until something else is bound
+	if (m_Program == program)
+		m_Program = Unknown;
+}
+
+void GLStateCache::DeleteVertexArray(unsigned int vertexArray)
+{
+	GLCall(glDeleteVertexArrays(1, &vertexArray));
+	if (m_VertexArray == vertexArray)
+		m_VertexArray = 0;
+	m_ElementBuffers.erase(vertexArray);
+}
+
+void GLStateCache::DeleteBuffer(unsigned int buffer)
+{
+	GLCall(glDeleteBuffers(1, &buffer));
+
+	// GL unbinds it from the context and the bound vertex array, other vertex arrays keep pointing at the dead
+	// buffer and the name may be handed out again, so forget those entries
+	if (m_ArrayBuffer == buffer)
+		m_ArrayBuffer = 0;
+	for (auto it = m_ElementBuffers.begin(); it != m_ElementBuffers.end(); ) {
+		if (it->second != buffer)
+			++it;
+		else if (it->first == m_VertexArray)
+			(it++)->second = 0;
+		else
+			it = m_ElementBuffers.erase(it);
+	}
+}
+
+void GLStateCache::DeleteTexture(unsigned int texture)
+{
+	GLCall(glDeleteTextures(1, &texture));
+	for (auto& unit : m_Textures) {
+		for (auto& bound : unit) {
+			if (bound == texture)
+				bound = 0;
+		}
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <unordered_map>
+
+struct GLStateStats {
+	unsigned int issued;		// calls that reached the driver
+	unsigned int elided;		// calls dropped because the state was already set
+};
+
+// shadows the GL state the renderer changes most (program, vertex array, array/element buffer, textures, blend/depth,
+// viewport, primitive restart) and drops calls that wouldn't change anything. There's one per context: Get() returns
+// the current one. All binds and deletes of these objects have to go through here, otherwise the shadow goes stale -
+// call Invalidate() after handing the context to code that doesn't. With validation on every call first checks the
+// shadow against glGet*.
+class GLStateCache
+{
+public:
+	static const unsigned int MaxTextureUnits = 32;		// units above this aren't cached
+
+private:
+	static const unsigned int Unknown = 0xFFFFFFFF;		// forces the next call through
+	static const unsigned int TextureTargets = 4;		// 2D, 2D array, 3D, cube map
+
+	unsigned int m_Program;
+	unsigned int m_VertexArray;
+	unsigned int m_ArrayBuffer;
+	// the element buffer binding is part of the vertex array's state, not the context's
+	std::unordered_map<unsigned int, unsigned int> m_ElementBuffers;
+	unsigned int m_ActiveTexture;
+	unsigned int m_Textures[MaxTextureUnits][TextureTargets];
+	unsigned int m_Blend;					// Unknown, GL_FALSE or GL_TRUE
+	unsigned int m_BlendSrc, m_BlendDst;
+	unsigned int m_DepthTest;
+	unsigned int m_DepthWrite;
+	unsigned int m_DepthFunc;
+	unsigned int m_PrimitiveRestart;
+	unsigned int m_RestartIndex;
+	bool m_RestartIndexKnown;			// every value is a valid index, Unknown included
+	int m_Viewport[4];
+	bool m_ViewportKnown;
+
+	bool m_Validate;
+	GLStateStats m_Stats;
+
+	static GLStateCache* s_Current;
+
+	bool Elide(bool unchanged);
+	void Check(unsigned int pname, unsigned int expected, const char* what) const;
+
+public:
+	GLStateCache();
+
+	/* the cache of the current context */
+	static GLStateCache& Get();
+	/* call when making another context current (nullptr goes back to the default cache) */
+	static void MakeCurrent(GLStateCache* cache);
+
+	void UseProgram(unsigned int program);
+	void BindVertexArray(unsigned int vertexArray);
+	/* GL_ARRAY_BUFFER and GL_ELEMENT_ARRAY_BUFFER are cached, other targets go straight through */
+	void BindBuffer(unsigned int target, unsigned int buffer);
+	/* glVertexArrayElementBuffer: attaches an element buffer to any vertex array without binding it (direct state
+	   access only) */
+	void SetElementBuffer(unsigned int vertexArray, unsigned int buffer);
+	void BindTexture(unsigned int unit, unsigned int target, unsigned int texture);
+
+	void SetBlend(bool enabled);
+	void SetBlendFunc(unsigned int src, unsigned int dst);
+	void SetDepthTest(bool enabled);
+	void SetDepthWrite(bool enabled);
+	void SetDepthFunc(unsigned int func);
+	void SetViewport(int x, int y, int width, int height);
+	/* index only matters when enabled */
+	void SetPrimitiveRestart(bool enabled, unsigned int index = 0xFFFFFFFF);
+
+	/* delete through these so the shadow never refers to a name that could be reused */
+	void DeleteProgram(unsigned int program);
+	void DeleteVertexArray(unsigned int vertexArray);
+	void DeleteBuffer(unsigned int buffer);
+	void DeleteTexture(unsigned int texture);
+
+	/* forget everything, the next call of each kind goes through */
+	void Invalidate();
+
+	/* compare every shadowed value against glGet* on each call (slow, it syncs with the driver) */
+	inline void SetValidation(bool enabled) { m_Validate = enabled; }
+	inline const GLStateStats& GetStats() const { return m_Stats; }
+	inline void ResetStats() { m_Stats.issued = 0; m_Stats.elided = 0; }
+};
@@ -0,0 +1,251 @@
+#include "HeadlessContext.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+#include <iostream>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace {
+
+	// the little of EGL and OSMesa we need, declared here so their headers aren't needed to build
+	typedef void* EGLDisplay;
+	typedef void* EGLContext;
+	typedef int EGLint;
+	typedef unsigned int EGLBoolean;
+	typedef unsigned int EGLenum;
+
+	const EGLint EGL_NONE = 0x3038;
+	const EGLenum EGL_OPENGL_API = 0x30A2;
+	const EGLint EGL_CONTEXT_MAJOR_VERSION = 0x3098;
+	const EGLint EGL_CONTEXT_MINOR_VERSION = 0x30FB;
+	const EGLint EGL_CONTEXT_OPENGL_PROFILE_MASK = 0x30FD;
+	const EGLint EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT = 0x0001;
+	const EGLint EGL_CONTEXT_OPENGL_DEBUG = 0x31B0;
+	const EGLenum EGL_PLATFORM_SURFACELESS_MESA = 0x31DD;
+
+	typedef void* (GLAPIENTRY *PFNEGLGETPROCADDRESS)(const char* name);
+	typedef EGLDisplay (GLAPIENTRY *PFNEGLGETPLATFORMDISPLAYEXT)(EGLenum platform, void* nativeDisplay, const EGLint* attribs);
+	typedef EGLBoolean (GLAPIENTRY *PFNEGLINITIALIZE)(EGLDisplay display, EGLint* major, EGLint* minor);
+	typedef EGLBoolean (GLAPIENTRY *PFNEGLTERMINATE)(EGLDisplay display);
+	typedef EGLBoolean (GLAPIENTRY *PFNEGLBINDAPI)(EGLenum api);
+	typedef EGLContext (GLAPIENTRY *PFNEGLCREATECONTEXT)(EGLDisplay display, void* config, EGLContext share, const EGLint* attribs);
+	typedef EGLBoolean (GLAPIENTRY *PFNEGLDESTROYCONTEXT)(EGLDisplay display, EGLContext context);
+	typedef EGLBoolean (GLAPIENTRY *PFNEGLMAKECURRENT)(EGLDisplay display, void* draw, void* read, EGLContext context);
+
+	const int OSMESA_FORMAT = 0x22;
+	const int OSMESA_RGBA = 0x1908;
+	const int OSMESA_DEPTH_BITS = 0x30;
+	const int OSMESA_PROFILE = 0x33;
+	const int OSMESA_CORE_PROFILE = 0x34;
+	const int OSMESA_CONTEXT_MAJOR_VERSION = 0x36;
+	const int OSMESA_CONTEXT_MINOR_VERSION = 0x37;
+
+	typedef void* (GLAPIENTRY *PFNOSMESACREATECONTEXTATTRIBS)(const int* attribs, void* share);
+	typedef GLboolean (GLAPIENTRY *PFNOSMESAMAKECURRENT)(void* context, void* buffer, GLenum type, GLsizei width, GLsizei height);
+	typedef void (GLAPIENTRY *PFNOSMESADESTROYCONTEXT)(void* context);
+
+#ifdef _WIN32
+	const char* EGLLibraries[] = { "libEGL.dll" };
+	const char* OSMesaLibraries[] = { "osmesa.dll" };
+
+	void* OpenLibrary(const char* name) { return LoadLibraryA(name); }
+	void* GetSymbol(void* library, const char* name) { return (void*)GetProcAddress((HMODULE)library, name); }
+	void CloseLibrary(void* library) { FreeLibrary((HMODULE)library); }
+#else
+	const char* EGLLibraries[] = { "libEGL.so.1", "libEGL.so" };
+	const char* OSMesaLibraries[] = { "libOSMesa.so.8", "libOSMesa.so.6", "libOSMesa.so" };
+
+	void* OpenLibrary(const char* name) { return dlopen(name, RTLD_NOW | RTLD_GLOBAL); }
+	void* GetSymbol(void* library, const char* name) { return dlsym(library, name); }
+	void CloseLibrary(void* library) { dlclose(library); }
+#endif
+
+	template<unsigned int N>
+	void* OpenFirstLibrary(const char* (&names)[N])
+	{
+		for (const char* name : names) {
+			if (void* library = OpenLibrary(name))
+				return library;
+		}
+		return nullptr;
+	}
+}
+
+HeadlessContext::HeadlessContext(int width, int height)
+	: GLContext(width, height), m_Library(nullptr), m_Display(nullptr), m_Context(nullptr), m_Framebuffer(0)
+{
+	m_Renderbuffers[0] = m_Renderbuffers[1] = 0;
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	if (m_Framebuffer) {
+		GLCall(glDeleteFramebuffers(1, &m_Framebuffer));
+		GLCall(glDeleteRenderbuffers(2, m_Renderbuffers));
+	}
+
+	if (m_Display) {
+		auto eglMakeCurrent = (PFNEGLMAKECURRENT)GetSymbol(m_Library, "eglMakeCurrent");
+		auto eglDestroyContext = (PFNEGLDESTROYCONTEXT)GetSymbol(m_Library, "eglDestroyContext");
+		auto eglTerminate = (PFNEGLTERMINATE)GetSymbol(m_Library, "eglTerminate");
+		eglMakeCurrent(m_Display, nullptr, nullptr, nullptr);
+		eglDestroyContext(m_Display, m_Context);
+		eglTerminate(m_Display);
+	}
+	else if (m_Context) {
+		auto OSMesaDestroyContext = (PFNOSMESADESTROYCONTEXT)GetSymbol(m_Library, "OSMesaDestroyContext");
+		OSMesaDestroyContext(m_Context);
+	}
+
+	if (m_Library)
+		CloseLibrary(m_Library);
+	GLStateCache::Get().Invalidate();
+}
+
+HeadlessContext * HeadlessContext::Create(int width, int height)
+{
+	HeadlessContext* context = new HeadlessContext(width, height);
+	if (context->CreateEGL() || context->CreateOSMesa())
+		return context;
+
+	std::cout << "No headless GL context available, install Mesa (libEGL with the surfaceless platform, or libOSMesa)" << std::endl;
+	delete context;
+	return nullptr;
+}
+
+bool HeadlessContext::CreateEGL()
+{
+	m_Library = OpenFirstLibrary(EGLLibraries);
+	if (!m_Library)
+		return false;
+
+	auto eglGetProcAddress = (PFNEGLGETPROCADDRESS)GetSymbol(m_Library, "eglGetProcAddress");
+	auto eglInitialize = (PFNEGLINITIALIZE)GetSymbol(m_Library, "eglInitialize");
+	auto eglTerminate = (PFNEGLTERMINATE)GetSymbol(m_Library, "eglTerminate");
+	auto eglBindAPI = (PFNEGLBINDAPI)GetSymbol(m_Library, "eglBindAPI");
+	auto eglCreateContext = (PFNEGLCREATECONTEXT)GetSymbol(m_Library, "eglCreateContext");
+	auto eglDestroyContext = (PFNEGLDESTROYCONTEXT)GetSymbol(m_Library, "eglDestroyContext");
+	auto eglMakeCurrent = (PFNEGLMAKECURRENT)GetSymbol(m_Library, "eglMakeCurrent");
+	auto eglGetPlatformDisplayEXT = eglGetProcAddress ? (PFNEGLGETPLATFORMDISPLAYEXT)eglGetProcAddress("eglGetPlatformDisplayEXT") : nullptr;
+	if (!eglGetPlatformDisplayEXT || !eglInitialize || !eglTerminate || !eglBindAPI ||
+		!eglCreateContext || !eglDestroyContext || !eglMakeCurrent) {
+		CloseLibrary(m_Library);
+		m_Library = nullptr;
+		return false;
+	}
+
+	// surfaceless: no window system at all, we render into our own framebuffer
+	EGLDisplay display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, nullptr, nullptr);
+	EGLint major, minor;
+	if (!display || !eglInitialize(display, &major, &minor)) {
+		CloseLibrary(m_Library);
+		m_Library = nullptr;
+		return false;
+	}
+
+	const EGLint contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 2,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+#ifdef _DEBUG
+		EGL_CONTEXT_OPENGL_DEBUG, 1,
+#endif
+		EGL_NONE
+	};
+
+	// no config (EGL_KHR_no_config_context, which Mesa's surfaceless platform always has), there's no surface for one
+	// to describe - the surfaceless configs don't even offer desktop GL
+	EGLContext context = nullptr;
+	if (eglBindAPI(EGL_OPENGL_API))
+		context = eglCreateContext(display, nullptr, nullptr, contextAttribs);
+	if (context && !eglMakeCurrent(display, nullptr, nullptr, context)) {
+		eglDestroyContext(display, context);
+		context = nullptr;
+	}
+	if (!context) {
+		eglTerminate(display);
+		CloseLibrary(m_Library);
+		m_Library = nullptr;
+		return false;
+	}
+
+	m_Display = display;
+	m_Context = context;
+	std::cout << "Headless: EGL " << major << "." << minor << " surfaceless" << std::endl;
+	return true;
+}
+
+bool HeadlessContext::CreateOSMesa()
+{
+	m_Library = OpenFirstLibrary(OSMesaLibraries);
+	if (!m_Library)
+		return false;
+
+	auto OSMesaCreateContextAttribs = (PFNOSMESACREATECONTEXTATTRIBS)GetSymbol(m_Library, "OSMesaCreateContextAttribs");
+	auto OSMesaMakeCurrent = (PFNOSMESAMAKECURRENT)GetSymbol(m_Library, "OSMesaMakeCurrent");
+	auto OSMesaDestroyContext = (PFNOSMESADESTROYCONTEXT)GetSymbol(m_Library, "OSMesaDestroyContext");
+	if (!OSMesaCreateContextAttribs || !OSMesaMakeCurrent || !OSMesaDestroyContext) {
+		CloseLibrary(m_Library);
+		m_Library = nullptr;
+		return false;
+	}
+
+	const int attribs[] = {
+		OSMESA_FORMAT, OSMESA_RGBA,
+		OSMESA_DEPTH_BITS, 24,
+		OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+		OSMESA_CONTEXT_MAJOR_VERSION, 4,
+		OSMESA_CONTEXT_MINOR_VERSION, 2,
+		0
+	};
+
+	void* context = OSMesaCreateContextAttribs(attribs, nullptr);
+	m_OSMesaBuffer.resize(m_Width * m_Height * 4);
+	if (context && !OSMesaMakeCurrent(context, m_OSMesaBuffer.data(), GL_UNSIGNED_BYTE, m_Width, m_Height)) {
+		OSMesaDestroyContext(context);
+		context = nullptr;
+	}
+	if (!context) {
+		CloseLibrary(m_Library);
+		m_Library = nullptr;
+		return false;
+	}
+
+	m_Context = context;
+	std::cout << "Headless: OSMesa" << std::endl;
+	return true;
+}
+
+bool HeadlessContext::OnLoaded()
+{
+	GLCall(glGenRenderbuffers(2, m_Renderbuffers));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_Renderbuffers[0]));
+	GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_Width, m_Height));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_Renderbuffers[1]));
+	GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_Width, m_Height));
+
+	GLCall(glGenFramebuffers(1, &m_Framebuffer));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer));
+	GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_Renderbuffers[0]));
+	GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_Renderbuffers[1]));
+
+	GLCall(GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+	if (GL_FRAMEBUFFER_COMPLETE != status) {
+		std::cout << "Headless framebuffer incomplete: " << status << std::endl;
+		return false;
+	}
+
+	// a surfaceless context starts with a 0x0 viewport
+	GLStateCache::Get().SetViewport(0, 0, m_Width, m_Height);
+	return true;
+}
+
+void HeadlessContext::SwapBuffers()
+{
+	GLCall(glFlush());
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "GLContext.h"
+#include <vector>
+
+// an offscreen GL 4.2 core context for machines with no display (and maybe no GPU - Mesa's llvmpipe is fine). Tries
+// EGL with EGL_MESA_platform_surfaceless first and falls back to OSMesa. Both libraries are loaded at runtime, so the
+// build doesn't depend on them and a windowed run never needs them. Everything is drawn into a framebuffer object
+// that stays bound, so code that draws to framebuffer 0 doesn't need to know.
+class HeadlessContext : public GLContext
+{
+private:
+	void* m_Library;			// libEGL or libOSMesa
+	void* m_Display;			// EGLDisplay, nullptr for OSMesa
+	void* m_Context;			// EGLContext or OSMesaContext
+	std::vector<unsigned char> m_OSMesaBuffer;	// OSMesa needs somewhere to render even though we use an FBO
+	unsigned int m_Framebuffer;
+	unsigned int m_Renderbuffers[2];	// colour, depth/stencil
+
+	HeadlessContext(int width, int height);
+
+	bool CreateEGL();
+	bool CreateOSMesa();
+
+protected:
+	bool OnLoaded() override;
+
+public:
+	~HeadlessContext();
+
+	/* nullptr if neither EGL nor OSMesa gave us a context */
+	static HeadlessContext* Create(int width, int height);
+
+	bool IsHeadless() const override { return true; }
+	bool ShouldClose() const override { return false; }
+	/* nothing to present, flushes so the frame's work gets going */
+	void SwapBuffers() override;
+	void PollEvents() override {}
+	void SetVSync(bool /*enabled*/) override {}
+};
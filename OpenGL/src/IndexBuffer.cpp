@@ -1,33 +1,133 @@
 #include "IndexBuffer.h"
 #include "Renderer.h"
+#include "GLStateCache.h"
+#include "GLBuffer.h"
+#include "BufferArena.h"
+#include <limits>
+#include <vector>
 
-IndexBuffer::IndexBuffer(const unsigned int * data, unsigned int count)
-	:m_Count(count)
+namespace {
+
+	template<typename In, typename Out>
+	std::vector<Out> Convert(const In* data, unsigned int count, bool primitiveRestart)
+	{
+		const In restartIn = std::numeric_limits<In>::max();
+		const Out restartOut = std::numeric_limits<Out>::max();
+
+		std::vector<Out> indices(count);
+		for (unsigned int i = 0; i < count; i++)
+			indices[i] = primitiveRestart && data[i] == restartIn ? restartOut : (Out)data[i];
+		return indices;
+	}
+}
+
+template<typename T>
+void IndexBuffer::Create(const T * data, BufferArena * arena)
+{
+	// the largest real index decides, with primitive restart the type's maximum is taken by the restart index
+	const T restart = std::numeric_limits<T>::max();
+	unsigned int largest = 0;
+	for (unsigned int i = 0; i < m_Count; i++) {
+		if (!(m_PrimitiveRestart && data[i] == restart) && data[i] > largest)
+			largest = data[i];
+	}
+	m_Type = largest < (m_PrimitiveRestart ? 0xFFFFu : 0x10000u) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+	std::vector<unsigned short> shorts;
+	std::vector<unsigned int> ints;
+	const void* indices;
+	if (GL_UNSIGNED_SHORT == m_Type) {
+		shorts = Convert<T, unsigned short>(data, m_Count, m_PrimitiveRestart);
+		indices = shorts.data();
+	}
+	else {
+		ints = Convert<T, unsigned int>(data, m_Count, m_PrimitiveRestart);
+		indices = ints.data();
+	}
+	const unsigned int size = m_Count * GetIndexSize();
+
+	if (arena) {
+		m_Allocation = arena->Allocate(size, GetIndexSize(), indices);
+		return;
+	}
+ 	// not through GL_ELEMENT_ARRAY_BUFFER: binding that would attach the buffer to whatever vertex array is bound,
+	// which may be shared by other meshes
+	m_RendererID = GLBuffer::CreateImmutable(size, indices, GL_STATIC_DRAW);
+}
+
+IndexBuffer::IndexBuffer(const unsigned int * data, unsigned int count, unsigned int primitive, bool primitiveRestart)
+	:m_RendererID(0), m_Count(count), m_Primitive(primitive), m_PrimitiveRestart(primitiveRestart), m_Arena(nullptr), m_Allocation(BufferArena::Invalid)
 {
 	// assuming we're on platform where unsigned int is 32bytes. Cherno prefers not to use GL specific types in code
 	ASSERT(sizeof(unsigned int) == sizeof(GLuint));
+	Create(data, nullptr);
+}
+
+IndexBuffer::IndexBuffer(const unsigned short * data, unsigned int count, unsigned int primitive, bool primitiveRestart)
+	:m_RendererID(0), m_Count(count), m_Primitive(primitive), m_PrimitiveRestart(primitiveRestart), m_Arena(nullptr), m_Allocation(BufferArena::Invalid)
+{
+	Create(data, nullptr);
+}
+
+IndexBuffer::IndexBuffer(const unsigned char * data, unsigned int count, unsigned int primitive, bool primitiveRestart)
+	:m_RendererID(0), m_Count(count), m_Primitive(primitive), m_PrimitiveRestart(primitiveRestart), m_Arena(nullptr), m_Allocation(BufferArena::Invalid)
+{
+	Create(data, nullptr);
+}
+
+IndexBuffer::IndexBuffer(unsigned int count)
+	:m_Count(count), m_Type(GL_UNSIGNED_INT), m_Primitive(GL_TRIANGLES), m_PrimitiveRestart(false), m_Arena(nullptr), m_Allocation(BufferArena::Invalid)
+{
+	m_RendererID = GLBuffer::CreateImmutable(count * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW);	// written piecewise
+}
 
- 	GLCall(glGenBuffers(1, &m_RendererID));	// get a buffer id
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));		// select the buffer
-	GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));	// assign data to the buffer
+IndexBuffer::IndexBuffer(BufferArena & arena, const unsigned int * data, unsigned int count, unsigned int primitive, bool primitiveRestart)
+	:m_RendererID(0), m_Count(count), m_Primitive(primitive), m_PrimitiveRestart(primitiveRestart), m_Arena(&arena), m_Allocation(BufferArena::Invalid)
+{
+	Create(data, &arena);
+}
+
+IndexBuffer::IndexBuffer(BufferArena & arena, const unsigned short * data, unsigned int count, unsigned int primitive, bool primitiveRestart)
+	:m_RendererID(0), m_Count(count), m_Primitive(primitive), m_PrimitiveRestart(primitiveRestart), m_Arena(&arena), m_Allocation(BufferArena::Invalid)
+{
+	Create(data, &arena);
 }
 
 IndexBuffer::~IndexBuffer()
 {
-	GLCall(glDeleteBuffers(1, &m_RendererID));
+	if (m_Arena)
+		m_Arena->Free(m_Allocation);
+	else
+		GLStateCache::Get().DeleteBuffer(m_RendererID);
 }
 
 void IndexBuffer::Bind() const
 {
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));		// select the buffer
+	GLStateCache::Get().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, GetRendererID());		// select the buffer
 }
 
 void IndexBuffer::Unbind() const
 {
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));		// select the buffer
+	GLStateCache::Get().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);		// select the buffer
+}
+
+void IndexBuffer::SetData(const unsigned int * data, unsigned int count, unsigned int first)
+{
+	ASSERT(first + count <= m_Count && GL_UNSIGNED_INT == m_Type);
+	if (m_Arena) {
+		m_Arena->SetData(m_Allocation, data, count * sizeof(unsigned int), first * sizeof(unsigned int));
+		return;
+	}
+
+	GLBuffer::SetSubData(m_RendererID, first * sizeof(unsigned int), count * sizeof(unsigned int), data);
+}
+
+unsigned int IndexBuffer::GetOffset() const
+{
+	return m_Arena ? m_Arena->Get(m_Allocation).offset : 0;
 }
 
-inline unsigned int IndexBuffer::GetCount() const
+unsigned int IndexBuffer::GetRendererID() const
 {
-	return m_Count;
+	return m_Arena ? m_Arena->Get(m_Allocation).buffer : m_RendererID;
 }
@@ -1,16 +1,54 @@
 #pragma once
+#include <GL/glew.h>
 
+class BufferArena;
+
+// indices are stored in the narrowest type that holds the largest one: GL_UNSIGNED_SHORT up to 65535 vertices (half
+// the memory and bandwidth of GL_UNSIGNED_INT), GL_UNSIGNED_INT above. 8 bit input is widened to 16 bit, GPUs don't
+// have a fast path for byte indices. Draws must use GetType() and GetPrimitive().
+// With primitive restart the input's maximum value (0xFF, 0xFFFF or 0xFFFFFFFF) ends one strip and starts the next,
+// it becomes the stored type's maximum.
 class IndexBuffer
 {
 private:
 	unsigned int m_RendererID;		// opengl id
 	unsigned int m_Count;			// number of indices
+	unsigned int m_Type;			// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	unsigned int m_Primitive;		// GL_TRIANGLES, GL_TRIANGLE_STRIP...
+	bool m_PrimitiveRestart;
+	BufferArena* m_Arena;			// set for a view into an arena, which owns the GL buffer then
+	unsigned int m_Allocation;		// handle in m_Arena
+
+	/* narrows data and puts it in a new buffer, or in arena if it's not nullptr */
+	template<typename T>
+	void Create(const T* data, BufferArena* arena);
 
 public:
-	IndexBuffer(const unsigned int *data, unsigned int count);
+	IndexBuffer(const unsigned int *data, unsigned int count, unsigned int primitive = GL_TRIANGLES, bool primitiveRestart = false);
+	IndexBuffer(const unsigned short* data, unsigned int count, unsigned int primitive = GL_TRIANGLES, bool primitiveRestart = false);
+	IndexBuffer(const unsigned char* data, unsigned int count, unsigned int primitive = GL_TRIANGLES, bool primitiveRestart = false);
+	/* room for count 32 bit indices, filled in pieces with SetData */
+	IndexBuffer(unsigned int count);
+	/* a view into arena, draws have to start at GetOffset() */
+	IndexBuffer(BufferArena& arena, const unsigned int* data, unsigned int count, unsigned int primitive = GL_TRIANGLES, bool primitiveRestart = false);
+	IndexBuffer(BufferArena& arena, const unsigned short* data, unsigned int count, unsigned int primitive = GL_TRIANGLES, bool primitiveRestart = false);
 	~IndexBuffer();
 	void Bind() const;
 	void Unbind() const;
 
-	inline unsigned int GetCount() const;
-};
\ No newline at end of file
+	/* writes count indices starting at index first, the rest of the buffer is left alone. 32 bit buffers only */
+	void SetData(const unsigned int* data, unsigned int count, unsigned int first);
+
+	inline unsigned int GetCount() const { return m_Count; }
+	inline unsigned int GetType() const { return m_Type; }
+	/* bytes per index */
+	inline unsigned int GetIndexSize() const { return GL_UNSIGNED_SHORT == m_Type ? 2 : 4; }
+	inline unsigned int GetPrimitive() const { return m_Primitive; }
+	inline bool HasPrimitiveRestart() const { return m_PrimitiveRestart; }
+	/* the index that restarts the primitive, the largest value of the type */
+	inline unsigned int GetRestartIndex() const { return GL_UNSIGNED_SHORT == m_Type ? 0xFFFF : 0xFFFFFFFF; }
+	/* bytes from the start of the bound buffer to the first index, 0 unless it's a view */
+	unsigned int GetOffset() const;
+	/* the GL buffer, the arena's for a view */
+	unsigned int GetRendererID() const;
+};
@@ -0,0 +1,46 @@
+#include "IndirectBuffer.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+#include "GLBuffer.h"
+
+IndirectBuffer::IndirectBuffer(unsigned int maxDraws)
+	: m_MaxDraws(maxDraws), m_Instances(0), m_Uploaded(0)
+{
+	m_Commands.reserve(maxDraws);
+
+	m_RendererID = GLBuffer::CreateImmutable(maxDraws * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+}
+
+IndirectBuffer::~IndirectBuffer()
+{
+	GLStateCache::Get().DeleteBuffer(m_RendererID);
+}
+
+void IndirectBuffer::Bind() const
+{
+	GLStateCache::Get().BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_RendererID);
+}
+
+void IndirectBuffer::Clear()
+{
+	m_Commands.clear();
+	m_Instances = 0;
+}
+
+unsigned int IndirectBuffer::Add(const Mesh & mesh, unsigned int instanceCount)
+{
+	ASSERT(m_Commands.size() < m_MaxDraws);
+	if (m_Commands.size() == m_MaxDraws)
+		return m_Instances;
+
+	DrawElementsIndirectCommand command = { mesh.indexCount, instanceCount, mesh.firstIndex, mesh.baseVertex, m_Instances };
+	m_Commands.push_back(command);
+	m_Instances += instanceCount;
+	return command.baseInstance;
+}
+
+void IndirectBuffer::Upload()
+{
+	GLBuffer::SetSubData(m_RendererID, 0, (unsigned int)m_Commands.size() * sizeof(DrawElementsIndirectCommand), m_Commands.data());
+	m_Uploaded = (unsigned int)m_Commands.size();
+}
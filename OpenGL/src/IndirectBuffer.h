@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include "MeshPool.h"
+
+// the layout glDrawElementsIndirect / glMultiDrawElementsIndirect read, it must not change
+struct DrawElementsIndirectCommand {
+	unsigned int count;
+	unsigned int instanceCount;
+	unsigned int firstIndex;
+	int baseVertex;
+	unsigned int baseInstance;
+};
+
+// draw commands for meshes of one MeshPool, kept in a GL_DRAW_INDIRECT_BUFFER so drawing all of them is a single
+// call (see Renderer::DrawIndirect). Commands are collected on the CPU and only sent by Upload(), after that they stay
+// on the GPU and can be drawn every frame for nothing until they change.
+// Each draw gets consecutive base instances, so its per draw data (MeshPool::AddDrawData) is found through an attribute
+// with a divisor of 1 - that works back to GL 4.2, gl_DrawID would need GL 4.6 or ARB_shader_draw_parameters.
+class IndirectBuffer
+{
+private:
+	unsigned int m_RendererID;		// opengl id
+	unsigned int m_MaxDraws;
+	std::vector<DrawElementsIndirectCommand> m_Commands;
+	unsigned int m_Instances;		// base instance of the next draw
+	unsigned int m_Uploaded;		// commands in the GL buffer
+
+public:
+	IndirectBuffer(unsigned int maxDraws);
+	~IndirectBuffer();
+	void Bind() const;
+
+	void Clear();
+	/* returns the draw's base instance, the index of its (first) per draw data element. Ignored when full */
+	unsigned int Add(const Mesh& mesh, unsigned int instanceCount = 1);
+	void Upload();
+
+	/* the commands on the GPU */
+	inline unsigned int GetCount() const { return m_Uploaded; }
+	inline const std::vector<DrawElementsIndirectCommand>& GetCommands() const { return m_Commands; }
+};
@@ -0,0 +1,216 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const unsigned int * indices, unsigned int indexCount, unsigned int vertexCount,
+	unsigned int cacheSize)
+{
+	// a vertex is in the FIFO if fewer than cacheSize misses happened since it went in
+	std::vector<unsigned int> entered(vertexCount, 0);
+	unsigned int time = cacheSize + 1;
+	VertexCacheStats stats = { 0.0f, 0.0f, 0 };
+	for (unsigned int i = 0; i < indexCount; i++) {
+		unsigned int vertex = indices[i];
+		if (time - entered[vertex] > cacheSize) {
+			entered[vertex] = time++;
+			stats.transformed++;
+		}
+	}
+
+	if (indexCount >= 3)
+		stats.acmr = (float)stats.transformed / (indexCount / 3);
+	if (vertexCount)
+		stats.atvr = (float)stats.transformed / vertexCount;
+	return stats;
+}
+
+std::vector<unsigned int> MeshOptimizer::Tipsify(const unsigned int * indices, unsigned int indexCount, unsigned int vertexCount,
+	unsigned int cacheSize, std::vector<unsigned int>* clusters)
+{
+	const unsigned int triangleCount = indexCount / 3;
+
+	// triangles using each vertex, flattened: vertex v's are adjacency[offsets[v]] to adjacency[offsets[v + 1]]
+	std::vector<unsigned int> live(vertexCount, 0);		// triangles left to emit per vertex
+	for (unsigned int i = 0; i < triangleCount * 3; i++)
+		live[indices[i]]++;
+	std::vector<unsigned int> offsets(vertexCount + 1, 0);
+	for (unsigned int v = 0; v < vertexCount; v++)
+		offsets[v + 1] = offsets[v] + live[v];
+	std::vector<unsigned int> adjacency(triangleCount * 3);
+	std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+	for (unsigned int t = 0; t < triangleCount; t++) {
+		for (unsigned int corner = 0; corner < 3; corner++)
+			adjacency[fill[indices[t * 3 + corner]]++] = t;
+	}
+
+	std::vector<unsigned int> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned int> deadEnd;			// recently used vertices, to fall back on when a fan runs out
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> result;
+	result.reserve(triangleCount * 3);
+	unsigned int time = cacheSize + 1;
+	unsigned int cursor = 0;					// for when even the dead end stack is empty
+	bool jumped = true;
+
+	int fanning = vertexCount ? 0 : -1;
+	while (fanning >= 0) {
+		if (jumped && clusters && result.size() < triangleCount * 3)
+			clusters->push_back((unsigned int)result.size());
+
+		// every remaining triangle around the fanning vertex
+		candidates.clear();
+		for (unsigned int a = offsets[fanning]; a < offsets[fanning + 1]; a++) {
+			unsigned int t = adjacency[a];
+			if (emitted[t])
+				continue;
+
+			for (unsigned int corner = 0; corner < 3; corner++) {
+				unsigned int v = indices[t * 3 + corner];
+				result.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				if (time - cacheTime[v] > cacheSize)
+					cacheTime[v] = time++;
+			}
+			emitted[t] = true;
+		}
+
+		// next: the candidate still in the cache that will stay there longest after its own triangles are emitted
+		int next = -1;
+		unsigned int best = 0;
+		for (unsigned int v : candidates) {
+			if (0 == live[v])
+				continue;
+			unsigned int priority = 0;
+			if (time - cacheTime[v] + 2 * live[v] <= cacheSize)
+				priority = time - cacheTime[v];
+			if (priority > best || -1 == next) {
+				best = priority;
+				next = (int)v;
+			}
+		}
+
+		jumped = -1 == next;
+		if (jumped) {
+			while (!deadEnd.empty() && -1 == next) {
+				unsigned int v = deadEnd.back();
+				deadEnd.pop_back();
+				if (live[v] > 0)
+					next = (int)v;
+			}
+			while (cursor < vertexCount && -1 == next) {
+				if (live[cursor] > 0)
+					next = (int)cursor;
+				cursor++;
+			}
+		}
+		fanning = next;
+	}
+	return result;
+}
+
+std::vector<unsigned int> MeshOptimizer::OptimizeVertexCache(const unsigned int * indices, unsigned int indexCount, unsigned int vertexCount,
+	unsigned int cacheSize)
+{
+	return Tipsify(indices, indexCount, vertexCount, cacheSize, nullptr);
+}
+
+std::vector<unsigned int> MeshOptimizer::OptimizeOverdraw(const unsigned int * indices, unsigned int indexCount, const float * positions,
+	unsigned int stride, unsigned int vertexCount, float threshold, unsigned int cacheSize)
+{
+	std::vector<unsigned int> starts;
+	std::vector<unsigned int> ordered = Tipsify(indices, indexCount, vertexCount, cacheSize, &starts);
+	starts.push_back((unsigned int)ordered.size());
+
+	auto position = [positions, stride](unsigned int v) {
+		return (const float*)((const char*)positions + (size_t)v * stride);
+	};
+
+	// area weighted centroid and normal of each cluster, and of the whole mesh
+	struct Cluster {
+		unsigned int begin, end;
+		float centroid[3];
+		float normal[3];
+		float key;
+	};
+	std::vector<Cluster> clusters;
+	float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+	float meshArea = 0.0f;
+	for (unsigned int c = 0; c + 1 < starts.size(); c++) {
+		Cluster cluster = { starts[c], starts[c + 1], { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, 0.0f };
+		float area = 0.0f;
+		for (unsigned int i = cluster.begin; i < cluster.end; i += 3) {
+			const float* p0 = position(ordered[i]);
+			const float* p1 = position(ordered[i + 1]);
+			const float* p2 = position(ordered[i + 2]);
+			float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			float a = 0.5f * std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			for (int k = 0; k < 3; k++) {
+				cluster.normal[k] += n[k];
+				cluster.centroid[k] += a * (p0[k] + p1[k] + p2[k]) / 3.0f;
+			}
+			area += a;
+		}
+		for (int k = 0; k < 3; k++)
+			meshCentroid[k] += cluster.centroid[k];
+		meshArea += area;
+		if (area > 0.0f) {
+			for (int k = 0; k < 3; k++)
+				cluster.centroid[k] /= area;
+		}
+		clusters.push_back(cluster);
+	}
+	if (meshArea > 0.0f) {
+		for (int k = 0; k < 3; k++)
+			meshCentroid[k] /= meshArea;
+	}
+
+	// how far out the cluster faces: clusters on the outside of the mesh pointing away from its centre are the ones
+	// most likely to cover the rest
+	for (Cluster& cluster : clusters) {
+		float length = std::sqrt(cluster.normal[0] * cluster.normal[0] + cluster.normal[1] * cluster.normal[1] + cluster.normal[2] * cluster.normal[2]);
+		if (length > 0.0f) {
+			for (int k = 0; k < 3; k++)
+				cluster.key += (cluster.centroid[k] - meshCentroid[k]) * cluster.normal[k] / length;
+		}
+	}
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.key > b.key; });
+
+	std::vector<unsigned int> sorted;
+	sorted.reserve(ordered.size());
+	for (const Cluster& cluster : clusters)
+		sorted.insert(sorted.end(), ordered.begin() + cluster.begin, ordered.begin() + cluster.end);
+
+	// cluster boundaries cost a few cache misses, too many of them and it's not worth it
+	float tipsifyAcmr = AnalyzeVertexCache(ordered.data(), (unsigned int)ordered.size(), vertexCount, cacheSize).acmr;
+	float sortedAcmr = AnalyzeVertexCache(sorted.data(), (unsigned int)sorted.size(), vertexCount, cacheSize).acmr;
+	return sortedAcmr <= tipsifyAcmr * threshold ? sorted : ordered;
+}
+
+unsigned int MeshOptimizer::OptimizeVertexFetch(void * vertices, unsigned int vertexSize, unsigned int vertexCount,
+	unsigned int * indices, unsigned int indexCount)
+{
+	const unsigned int unused = 0xFFFFFFFF;
+	std::vector<unsigned int> remap(vertexCount, unused);
+	unsigned int used = 0;
+	for (unsigned int i = 0; i < indexCount; i++) {
+		unsigned int& target = remap[indices[i]];
+		if (unused == target)
+			target = used++;
+		indices[i] = target;
+	}
+
+	std::vector<char> reordered((size_t)used * vertexSize);
+	for (unsigned int v = 0; v < vertexCount; v++) {
+		if (unused != remap[v])
+			std::memcpy(&reordered[(size_t)remap[v] * vertexSize], (const char*)vertices + (size_t)v * vertexSize, vertexSize);
+	}
+	if (used)
+		std::memcpy(vertices, reordered.data(), reordered.size());
+	return used;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+
+struct VertexCacheStats {
+	float acmr;					// average cache miss ratio: vertices transformed per triangle, 3 at worst, 0.5 is the best a grid gets
+	float atvr;					// average transformed vertex ratio: transforms per vertex, 1 is ideal
+	unsigned int transformed;	// vertex shader invocations
+};
+
+// load time reordering of indexed triangle lists (CPU only, no GL) so the GPU runs the vertex shader less often:
+//  - OptimizeVertexCache: triangle order for the post transform cache, Tipsify (Sander, Nehab, Barczak 2007).
+//    Linear in the number of triangles and doesn't depend much on the real cache size
+//  - OptimizeOverdraw: Tipsify, then the clusters it produces sorted so outward facing ones come first (the mesh
+//    occludes more of itself when drawn front to back), kept only if the cache efficiency stays within threshold
+//  - OptimizeVertexFetch: vertices in the order the indices first use them, so fetches walk memory forwards.
+//    Do it last, after the triangles are in their final order
+// AnalyzeVertexCache simulates a FIFO cache to measure the effect, the usual model for comparing orders.
+class MeshOptimizer
+{
+public:
+	static const unsigned int DefaultCacheSize = 16;
+
+private:
+	/* clusters: if not nullptr gets the index (into the result) where each run of adjacent triangles starts */
+	static std::vector<unsigned int> Tipsify(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount,
+		unsigned int cacheSize, std::vector<unsigned int>* clusters);
+
+public:
+	static VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount,
+		unsigned int cacheSize = DefaultCacheSize);
+
+	/* returns the reordered indices (the same triangles, each keeps its winding) */
+	static std::vector<unsigned int> OptimizeVertexCache(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount,
+		unsigned int cacheSize = DefaultCacheSize);
+	/* positions: x, y, z of vertex 0, the next vertex's stride bytes further. threshold: how much worse than Tipsify's
+	   ACMR the sorted order may be, 1.05 = 5% */
+	static std::vector<unsigned int> OptimizeOverdraw(const unsigned int* indices, unsigned int indexCount, const float* positions,
+		unsigned int stride, unsigned int vertexCount, float threshold = 1.05f, unsigned int cacheSize = DefaultCacheSize);
+	/* reorders vertices (vertexSize bytes each) in place and remaps indices to match. Unreferenced vertices are dropped,
+	   returns how many are left */
+	static unsigned int OptimizeVertexFetch(void* vertices, unsigned int vertexSize, unsigned int vertexCount,
+		unsigned int* indices, unsigned int indexCount);
+};
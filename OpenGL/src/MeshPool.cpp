@@ -0,0 +1,32 @@
+#include "MeshPool.h"
+#include "Renderer.h"
+
+MeshPool::MeshPool(const VertexBufferLayout & layout, unsigned int maxVertices, unsigned int maxIndices)
+	: m_VertexBuffer(maxVertices * layout.GetStride()), m_IndexBuffer(maxIndices), m_Stride(layout.GetStride()),
+	m_MaxVertices(maxVertices), m_VertexCount(0), m_MaxIndices(maxIndices), m_IndexCount(0)
+{
+	m_VertexArray.AddBuffer(m_VertexBuffer, layout);
+	m_VertexArray.SetIndexBuffer(m_IndexBuffer);
+}
+
+bool MeshPool::Add(const void * vertices, unsigned int vertexCount, const unsigned int * indices, unsigned int indexCount, Mesh & mesh)
+{
+	if (m_VertexCount + vertexCount > m_MaxVertices || m_IndexCount + indexCount > m_MaxIndices)
+		return false;
+
+	m_VertexBuffer.SetSubData(vertices, vertexCount * m_Stride, m_VertexCount * m_Stride);
+	m_IndexBuffer.SetData(indices, indexCount, m_IndexCount);
+
+	mesh.firstIndex = m_IndexCount;
+	mesh.indexCount = indexCount;
+	mesh.baseVertex = (int)m_VertexCount;
+	m_VertexCount += vertexCount;
+	m_IndexCount += indexCount;
+	return true;
+}
+
+void MeshPool::AddDrawData(const VertexBuffer & vb, const VertexBufferLayout & layout)
+{
+	ASSERT(layout.GetDivisor() == 1);
+	m_VertexArray.AddBuffer(vb, layout);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+
+// where a mesh lives in a MeshPool's buffers
+struct Mesh {
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	int baseVertex;				// added to every index, so a mesh's indices start at 0 like they would in its own buffer
+};
+
+// many meshes sharing one vertex buffer and one index buffer, so a single vertex array (and a single bind) covers all
+// of them and they can be drawn together from an IndirectBuffer. Space is handed out front to back and never reused.
+class MeshPool
+{
+private:
+	VertexArray m_VertexArray;
+	VertexBuffer m_VertexBuffer;
+	IndexBuffer m_IndexBuffer;
+	unsigned int m_Stride;
+	unsigned int m_MaxVertices, m_VertexCount;
+	unsigned int m_MaxIndices, m_IndexCount;
+
+public:
+	/* every mesh has vertices in this layout */
+	MeshPool(const VertexBufferLayout& layout, unsigned int maxVertices, unsigned int maxIndices);
+
+	/* copies the mesh into the pool, false if it doesn't fit */
+	bool Add(const void* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount, Mesh& mesh);
+	/* per draw data, one element per draw: give the layout a divisor of 1, the draw's base instance picks its element */
+	void AddDrawData(const VertexBuffer& vb, const VertexBufferLayout& layout);
+
+	inline const VertexArray& GetVertexArray() const { return m_VertexArray; }
+	inline const IndexBuffer& GetIndexBuffer() const { return m_IndexBuffer; }
+	inline unsigned int GetVertexCount() const { return m_VertexCount; }
+	inline unsigned int GetIndexCount() const { return m_IndexCount; }
+};
@@ -0,0 +1,85 @@
+#include "ParallelRecorder.h"
+#include "RenderQueue.h"
+#include "Renderer.h"
+
+ParallelRecorder::ParallelRecorder(unsigned int threads)
+	: m_Record(nullptr), m_Count(0), m_Generation(0), m_Pending(0), m_Running(true)
+{
+	ASSERT(threads >= 1);
+	for (unsigned int i = 0; i < threads; i++)
+		m_Queues.emplace_back(new RenderQueue());
+	for (unsigned int i = 1; i < threads; i++)
+		m_Workers.emplace_back(&ParallelRecorder::Run, this, i);
+}
+
+ParallelRecorder::~ParallelRecorder()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Running = false;
+	}
+	m_Start.notify_all();
+	for (std::thread& worker : m_Workers)
+		worker.join();
+}
+
+void ParallelRecorder::RecordRange(unsigned int thread, const RecordFunction & record, unsigned int count)
+{
+	const unsigned int threads = GetThreadCount();
+	const unsigned int first = (unsigned int)((unsigned long long)count * thread / threads);
+	const unsigned int last = (unsigned int)((unsigned long long)count * (thread + 1) / threads);
+	if (first < last)
+		record(thread, first, last, *m_Queues[thread]);
+}
+
+void ParallelRecorder::Run(unsigned int thread)
+{
+	unsigned int generation = 0;
+	for (;;) {
+		const RecordFunction* record;
+		unsigned int count;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Start.wait(lock, [&] { return !m_Running || m_Generation != generation; });
+			if (!m_Running)
+				return;
+			generation = m_Generation;
+			record = m_Record;
+			count = m_Count;
+		}
+
+		RecordRange(thread, *record, count);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (0 == --m_Pending)
+			m_Done.notify_one();
+	}
+}
+
+void ParallelRecorder::Record(unsigned int count, const RecordFunction & record)
+{
+	if (!m_Workers.empty()) {
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Record = &record;
+			m_Count = count;
+			m_Pending = (unsigned int)m_Workers.size();
+			m_Generation++;
+		}
+		m_Start.notify_all();
+	}
+
+	RecordRange(0, record, count);
+
+	// record has to stay alive until the last worker is done with it
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Done.wait(lock, [this] { return 0 == m_Pending; });
+}
+
+void ParallelRecorder::Merge(RenderQueue & queue)
+{
+	for (auto& threadQueue : m_Queues) {
+		queue.Append(*threadQueue);
+		threadQueue->Clear();
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class RenderQueue;
+
+// records a frame's draws on several threads while only the render thread talks to GL. The objects are split into one
+// contiguous range per thread and each thread records its range into its own RenderQueue (culling, sort keys, writing
+// per draw data into mapped memory - anything that doesn't call GL), then the render thread merges the queues into
+// one and executes it. The calling thread records the first range itself, so one thread means no workers at all.
+//   Record(count, record) -> Merge(queue) -> queue.Execute()
+class ParallelRecorder
+{
+public:
+	/* records objects first to last - 1 into queue. thread (0 is the caller) is for per thread scratch data */
+	typedef std::function<void(unsigned int thread, unsigned int first, unsigned int last, RenderQueue& queue)> RecordFunction;
+
+private:
+	std::vector<std::thread> m_Workers;						// threads 1..n-1
+	std::vector<std::unique_ptr<RenderQueue>> m_Queues;		// one per thread, apart so they don't share cache lines
+
+	std::mutex m_Mutex;						// guards everything below, shared with the workers
+	std::condition_variable m_Start;		// a new Record() or shutting down
+	std::condition_variable m_Done;			// the last worker finished its range
+	const RecordFunction* m_Record;
+	unsigned int m_Count;
+	unsigned int m_Generation;				// Record() calls so far, a worker runs once per generation
+	unsigned int m_Pending;					// workers still recording
+	bool m_Running;
+
+	void Run(unsigned int thread);
+	void RecordRange(unsigned int thread, const RecordFunction& record, unsigned int count);
+
+public:
+	/* threads: including the calling one */
+	ParallelRecorder(unsigned int threads);
+	~ParallelRecorder();
+
+	/* returns once every thread has recorded its part of [0, count) */
+	void Record(unsigned int count, const RecordFunction& record);
+	/* appends every thread's commands to queue, in thread order, and empties theirs */
+	void Merge(RenderQueue& queue);
+
+	inline unsigned int GetThreadCount() const { return (unsigned int)m_Queues.size(); }
+};
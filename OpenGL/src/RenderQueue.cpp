@@ -0,0 +1,179 @@
+#include "RenderQueue.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "VertexArray.h"
+#include "IndexBuffer.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <chrono>
+
+RenderQueue::RenderQueue(bool sort)
+	: m_Sort(sort), m_Stats{ 0, 0, 0, 0, 0.0 }
+{
+}
+
+unsigned long long RenderQueue::MakeKey(unsigned int layer, bool translucent, unsigned int shader, unsigned int material, float depth)
+{
+	ASSERT(layer < 16 && shader < (1u << 12) && material < (1u << 16));
+	const unsigned long long quantized = (unsigned long long)(std::min(std::max(depth, 0.0f), 1.0f) * 0xFFFFFF);
+	unsigned long long key = (unsigned long long)(layer & 0xF) << 60;
+	if (!translucent)
+		return key | (unsigned long long)(shader & 0xFFF) << 47 | (unsigned long long)(material & 0xFFFF) << 31 | quantized << 7;
+	return key | TranslucentBit | (0xFFFFFF - quantized) << 35 | (unsigned long long)(shader & 0xFFF) << 23
+		| (unsigned long long)(material & 0xFFFF) << 7;
+}
+
+void RenderQueue::Submit(const RenderCommand & command)
+{
+	m_Commands.push_back(command);
+	m_Commands.back().firstUniform = (unsigned int)m_Uniforms.size();
+	m_Commands.back().uniformCount = 0;
+}
+
+void RenderQueue::AddUniform(const UniformName & name, unsigned int count, float x, float y, float z, float w)
+{
+	ASSERT(!m_Commands.empty() && count >= 1 && count <= 4);
+	m_Uniforms.push_back({ name, { x, y, z, w }, count });
+	m_Commands.back().uniformCount++;
+}
+
+void RenderQueue::Append(const RenderQueue & other)
+{
+	const unsigned int uniformOffset = (unsigned int)m_Uniforms.size();
+	const size_t first = m_Commands.size();
+	m_Commands.insert(m_Commands.end(), other.m_Commands.begin(), other.m_Commands.end());
+	for (size_t i = first; i < m_Commands.size(); i++)
+		m_Commands[i].firstUniform += uniformOffset;
+	m_Uniforms.insert(m_Uniforms.end(), other.m_Uniforms.begin(), other.m_Uniforms.end());
+}
+
+void RenderQueue::Clear()
+{
+	m_Commands.clear();
+	m_Uniforms.clear();
+}
+
+void RenderQueue::Sort(std::vector<SortItem>& items, std::vector<SortItem>& scratch)
+{
+	const size_t count = items.size();
+	if (count < 2)
+		return;		// nothing to order (and no source[0] to look at below)
+	scratch.resize(count);
+
+	// every pass's histogram in one read of the keys, on the stack (8KB) rather than allocated every call
+	static const unsigned int Passes = 8;
+	unsigned int histograms[Passes][256] = {};
+	for (const SortItem& item : items) {
+		for (unsigned int pass = 0; pass < Passes; pass++)
+			histograms[pass][(item.key >> (pass * 8)) & 0xFF]++;
+	}
+
+	SortItem* source = items.data();
+	SortItem* destination = scratch.data();
+	for (unsigned int pass = 0; pass < Passes; pass++) {
+		unsigned int* histogram = histograms[pass];
+		const unsigned int shift = pass * 8;
+		if (histogram[(source[0].key >> shift) & 0xFF] == count)
+			continue;		// every key has this byte, the order wouldn't change
+
+		// counts to offsets, then scatter: items keep their relative order within a bucket, which makes it stable
+		unsigned int offset = 0;
+		for (unsigned int bucket = 0; bucket < 256; bucket++) {
+			unsigned int n = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += n;
+		}
+		for (size_t i = 0; i < count; i++)
+			destination[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+		std::swap(source, destination);
+	}
+
+	if (source != items.data())
+		items.swap(scratch);
+}
+
+unsigned int RenderQueue::CountChanges(const RenderCommand & a, const RenderCommand & b)
+{
+	return (a.shader != b.shader || a.mask != b.mask ? 1 : 0) + (a.vertexArray != b.vertexArray ? 1 : 0)
+		+ (a.texture != b.texture ? 1 : 0) + ((a.key ^ b.key) & TranslucentBit ? 1 : 0);
+}
+
+const RenderQueueStats & RenderQueue::Execute()
+{
+	m_Stats.commands = (unsigned int)m_Commands.size();
+	m_Stats.draws = 0;
+	m_Stats.stateChanges = 0;
+	m_Stats.unsortedStateChanges = 0;
+	m_Stats.sortMs = 0.0;
+	if (m_Commands.empty())
+		return m_Stats;
+
+	for (size_t i = 1; i < m_Commands.size(); i++)
+		m_Stats.unsortedStateChanges += CountChanges(m_Commands[i - 1], m_Commands[i]);
+
+	m_Items.resize(m_Commands.size());
+	for (unsigned int i = 0; i < m_Items.size(); i++)
+		m_Items[i] = { m_Commands[i].key, i };
+	if (m_Sort) {
+		auto start = std::chrono::high_resolution_clock::now();
+		Sort(m_Items, m_Scratch);
+		m_Stats.sortMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	GLStateCache& cache = GLStateCache::Get();
+	const RenderCommand* previous = nullptr;
+	bool bound = false;		// the previous command's shader is bound
+	for (const SortItem& item : m_Items) {
+		const RenderCommand& command = m_Commands[item.index];
+		if (previous)
+			m_Stats.stateChanges += CountChanges(*previous, command);
+
+		// the state cache drops everything that didn't change since the last command
+		if (!previous || previous->shader != command.shader || previous->mask != command.mask)
+			bound = command.shader->Bind(command.mask);
+		previous = &command;
+		if (!bound)
+			continue;		// still compiling
+
+		const bool translucent = (command.key & TranslucentBit) != 0;
+		cache.SetBlend(translucent);
+		if (translucent)
+			cache.SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		cache.SetDepthWrite(!translucent);
+		if (command.texture)
+			cache.BindTexture(0, GL_TEXTURE_2D, command.texture);
+
+		const IndexBuffer& ib = *command.indexBuffer;
+		command.vertexArray->Bind();
+		ib.Bind();
+		cache.SetPrimitiveRestart(ib.HasPrimitiveRestart(), ib.GetRestartIndex());
+
+		for (unsigned int i = command.firstUniform; i < command.firstUniform + command.uniformCount; i++) {
+			const Uniform& uniform = m_Uniforms[i];
+			const float* v = uniform.value;
+			switch (uniform.count) {
+			case 1: command.shader->SetUniform(uniform.name, v[0]); break;
+			case 2: command.shader->SetUniform(uniform.name, v[0], v[1]); break;
+			case 3: command.shader->SetUniform(uniform.name, v[0], v[1], v[2]); break;
+			default: command.shader->SetUniform(uniform.name, v[0], v[1], v[2], v[3]); break;
+			}
+		}
+
+		const unsigned int count = command.indexCount ? command.indexCount : ib.GetCount();
+		void* offset = (void*)(size_t)(ib.GetOffset() + command.firstIndex * ib.GetIndexSize());
+		if (command.baseInstance) {
+			GLCall(glDrawElementsInstancedBaseVertexBaseInstance(ib.GetPrimitive(), count, ib.GetType(), offset,
+				command.instanceCount > 1 ? command.instanceCount : 1, command.baseVertex, command.baseInstance));
+		}
+		else if (command.instanceCount > 1) {
+			GLCall(glDrawElementsInstancedBaseVertex(ib.GetPrimitive(), count, ib.GetType(), offset, command.instanceCount, command.baseVertex));
+		}
+		else {
+			GLCall(glDrawElementsBaseVertex(ib.GetPrimitive(), count, ib.GetType(), offset, command.baseVertex));
+		}
+		m_Stats.draws++;
+	}
+
+	Clear();
+	return m_Stats;
+}
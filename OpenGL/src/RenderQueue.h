@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+#include "UniformTable.h"
+
+class Shader;
+class VertexArray;
+class IndexBuffer;
+
+struct RenderCommand {
+	unsigned long long key;				// RenderQueue::MakeKey, commands are drawn in increasing key order
+	Shader* shader;
+	unsigned int mask;					// the shader permutation
+	const VertexArray* vertexArray;
+	const IndexBuffer* indexBuffer;
+	unsigned int texture;				// GL_TEXTURE_2D on unit 0, 0 leaves the unit alone
+	unsigned int firstIndex;
+	unsigned int indexCount;			// 0 draws the whole index buffer
+	int baseVertex;
+	unsigned int instanceCount;			// 0 or 1 is a plain draw
+	unsigned int baseInstance;			// offsets per instance attributes, e.g. to this draw's data in a buffer
+	unsigned int firstUniform;			// set by the queue
+	unsigned int uniformCount;
+};
+
+struct RenderQueueStats {
+	unsigned int commands;
+	unsigned int draws;					// commands whose shader was ready
+	unsigned int stateChanges;			// program, vertex array, texture and blend changes from one command to the next
+	unsigned int unsortedStateChanges;	// the same in the order the commands were submitted
+	double sortMs;
+};
+
+// deferred draws: commands are collected over the frame into linear arrays (no allocation once they've grown to the
+// frame's size), radix sorted by their 64 bit key and then replayed through the state cache, which drops whatever
+// the sort made redundant. The key decides the order:
+//   63..60 layer | 59 translucent | opaque:      58..47 shader | 46..31 material | 30..7 depth, front to back
+//                                 | translucent: 58..35 depth, back to front | 34..23 shader | 22..7 material
+// Opaque draws are grouped by state and drawn front to back within a group (for early depth rejection), translucent
+// ones back to front so they blend correctly - with blending on (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA) and depth
+// writes off. Shader and material are ids the caller picks (12 and 16 bits): the same id must mean the same state.
+//   Submit() + AddUniform() ... -> Execute() -> Submit() ...
+class RenderQueue
+{
+public:
+	struct SortItem {
+		unsigned long long key;
+		unsigned int index;				// into the submitted commands
+	};
+
+private:
+	struct Uniform {
+		UniformName name;
+		float value[4];
+		unsigned int count;				// components
+	};
+
+	std::vector<RenderCommand> m_Commands;
+	std::vector<Uniform> m_Uniforms;
+	std::vector<SortItem> m_Items;
+	std::vector<SortItem> m_Scratch;
+	bool m_Sort;
+	RenderQueueStats m_Stats;
+
+	/* state changes going from command a to command b */
+	static unsigned int CountChanges(const RenderCommand& a, const RenderCommand& b);
+
+public:
+	static const unsigned long long TranslucentBit = 1ull << 59;
+
+	/* sort: false replays in submission order, to measure what sorting saves */
+	RenderQueue(bool sort = true);
+
+	/* layer 0-15 is drawn in order, depth 0 (near) to 1 (far) */
+	static unsigned long long MakeKey(unsigned int layer, bool translucent, unsigned int shader, unsigned int material, float depth);
+
+	/* firstUniform and uniformCount are filled in */
+	void Submit(const RenderCommand& command);
+	/* a float, vec2, vec3 or vec4 uniform (count components) set before the last submitted command draws */
+	void AddUniform(const UniformName& name, unsigned int count, float x, float y = 0.0f, float z = 0.0f, float w = 0.0f);
+
+	/* adds other's commands (and their uniforms) after ours, other is left as it is */
+	void Append(const RenderQueue& other);
+
+	/* sorts, draws everything submitted and empties the queue for the next frame */
+	const RenderQueueStats& Execute();
+	/* drops the commands without drawing them */
+	void Clear();
+
+	/* stable LSD radix sort by key, 8 bits a pass. Passes where every key has the same byte are skipped, so unused
+	   key bits cost nothing. scratch is resized to match */
+	static void Sort(std::vector<SortItem>& items, std::vector<SortItem>& scratch);
+
+	inline unsigned int GetCount() const { return (unsigned int)m_Commands.size(); }
+	inline bool IsSorted() const { return m_Sort; }
+	/* of the last Execute() */
+	inline const RenderQueueStats& GetStats() const { return m_Stats; }
+};
@@ -1,13 +1,27 @@
-#include "renderer.h"
+#include "Renderer.h"
+#include "GLDebug.h"
+#include "VertexArray.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+#include "IndirectBuffer.h"
+#include "GLStateCache.h"
 #include <iostream>
 
+// both do nothing once the debug callback is installed in a debug context, it reports errors as they happen without a
+// driver round trip
 void GLClearError()
 {
+	if (GLDebug::ReportsErrors())
+		return;
+
 	while (glGetError() != GL_NO_ERROR);
 }
 
 bool GLLogCall(const char *function, const char* file, int line)
 {
+	if (GLDebug::ReportsErrors())
+		return true;
+
 	if (GLenum error = glGetError())		//GL_NO_ERROR is 0
 	{
 		std::cout << "GL Error " << error << " in " << function << " " << file << ": " << line << std::endl;
@@ -16,3 +30,63 @@ bool GLLogCall(const char *function, const char* file, int line)
 	else
 		return true;
 }
+
+namespace {
+
+	void BindGeometry(const VertexArray& va, const IndexBuffer& ib)
+	{
+		va.Bind();
+		ib.Bind();
+		GLStateCache::Get().SetPrimitiveRestart(ib.HasPrimitiveRestart(), ib.GetRestartIndex());
+	}
+}
+
+void Renderer::Clear() const
+{
+	GLCall(glClear(GL_COLOR_BUFFER_BIT));
+}
+
+bool Renderer::Draw(const VertexArray & va, const IndexBuffer & ib, Shader & shader, unsigned int mask) const
+{
+	if (!shader.Bind(mask))
+		return false;
+
+	BindGeometry(va, ib);
+	GLCall(glDrawElements(ib.GetPrimitive(), ib.GetCount(), ib.GetType(), (const void*)(size_t)ib.GetOffset()));
+	return true;
+}
+
+bool Renderer::DrawInstanced(const VertexArray & va, const IndexBuffer & ib, Shader & shader, unsigned int instanceCount,
+	unsigned int baseInstance, unsigned int mask) const
+{
+	if (!shader.Bind(mask))
+		return false;
+
+	BindGeometry(va, ib);
+	if (baseInstance) {
+		GLCall(glDrawElementsInstancedBaseInstance(ib.GetPrimitive(), ib.GetCount(), ib.GetType(), (const void*)(size_t)ib.GetOffset(), instanceCount, baseInstance));
+	}
+	else {
+		GLCall(glDrawElementsInstanced(ib.GetPrimitive(), ib.GetCount(), ib.GetType(), (const void*)(size_t)ib.GetOffset(), instanceCount));
+	}
+	return true;
+}
+
+bool Renderer::DrawIndirect(const VertexArray & va, const IndexBuffer & ib, const IndirectBuffer & commands, Shader & shader,
+	unsigned int mask) const
+{
+	if (!shader.Bind(mask))
+		return false;
+
+	BindGeometry(va, ib);
+	commands.Bind();
+	if (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect) {
+		GLCall(glMultiDrawElementsIndirect(ib.GetPrimitive(), ib.GetType(), nullptr, commands.GetCount(), 0));
+	}
+	else {
+		for (unsigned int i = 0; i < commands.GetCount(); i++) {
+			GLCall(glDrawElementsIndirect(ib.GetPrimitive(), ib.GetType(), (const void*)(i * sizeof(DrawElementsIndirectCommand))));
+		}
+	}
+	return true;
+}
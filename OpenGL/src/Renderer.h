@@ -0,0 +1,45 @@
+#pragma once
+
+#include <GL/glew.h>
+
+//#define ASSERT(x) if(!(x)) assert(false);
+#ifdef _MSC_VER
+#define ASSERT(x) if(!(x)) __debugbreak();	// note that __ indicates this is a MSVC compiler intrinsic call; won't work with other compilers
+#else
+#include <csignal>
+#define ASSERT(x) if(!(x)) raise(SIGTRAP);	// same thing for gcc/clang, stops in the debugger (or kills the process without one)
+#endif
+
+// checks glGetError around the call, unless GLDebug has installed the debug callback (then only the call remains)
+#ifdef _DEBUG
+#define GLCall(x) GLClearError();\
+	x;\
+	ASSERT(GLLogCall(#x, __FILE__, __LINE__))
+#else
+#define GLCall(x) x
+#endif
+
+void GLClearError();
+
+bool GLLogCall(const char *function, const char* file, int line);
+
+
+class VertexArray;
+class IndexBuffer;
+class Shader;
+class IndirectBuffer;
+
+class Renderer
+{
+public:
+	void Clear() const;
+	/* binds everything and draws the whole index buffer, false (nothing drawn) while the shader is still compiling */
+	bool Draw(const VertexArray& va, const IndexBuffer& ib, Shader& shader, unsigned int mask = 0) const;
+	/* the same instanceCount times, per instance attributes (see VertexBufferLayout's divisor) start at baseInstance */
+	bool DrawInstanced(const VertexArray& va, const IndexBuffer& ib, Shader& shader, unsigned int instanceCount,
+		unsigned int baseInstance = 0, unsigned int mask = 0) const;
+	/* every uploaded command of commands in one call: glMultiDrawElementsIndirect with GL 4.3 or ARB_multi_draw_indirect,
+	   otherwise a glDrawElementsIndirect per command (still nothing but an offset from the CPU) */
+	bool DrawIndirect(const VertexArray& va, const IndexBuffer& ib, const IndirectBuffer& commands, Shader& shader,
+		unsigned int mask = 0) const;
+};
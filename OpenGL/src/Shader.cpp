@@ -0,0 +1,385 @@
+#include "Shader.h"
+#include "ShaderPreprocessor.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+	const unsigned int InitialCapacity = 16;	// must be a power of two
+
+	inline unsigned int HashMask(unsigned int mask)
+	{
+		return mask * 2654435761u;		// Knuth's multiplicative hash, the masks themselves are very regular
+	}
+}
+
+unsigned int Shader::s_DependencyEpoch = 0;
+
+Shader::Shader(const std::string & filepath, const std::vector<std::string>& keywords, ShaderPreprocessor & preprocessor, ShaderCompiler & compiler,
+	const std::vector<ShaderDefine>& defines)
+	: m_Filepath(filepath), m_Keywords(keywords), m_Defines(defines), m_Preprocessor(preprocessor), m_Compiler(compiler),
+	m_Permutations(InitialCapacity), m_PermutationCount(0), m_Bound(nullptr),
+	m_DependencyVersion(0), m_PendingReloads(0)
+{
+	ASSERT(keywords.size() <= 32);
+}
+
+Shader::~Shader()
+{
+	for (const auto& permutation : m_Permutations) {
+		if (!permutation.occupied)
+			continue;
+		if (permutation.program) {
+			GLStateCache::Get().DeleteProgram(permutation.program);
+		}
+		else if (permutation.handle)
+			m_Compiler.Discard(permutation.handle);		// still compiling (or failed): nobody would delete it
+		if (permutation.reloadHandle)
+			m_Compiler.Discard(permutation.reloadHandle);
+	}
+}
+
+unsigned int Shader::GetKeywordMask(const std::string & keyword) const
+{
+	for (unsigned int i = 0; i < m_Keywords.size(); i++) {
+		if (m_Keywords[i] == keyword)
+			return 1u << i;
+	}
+	return 0;
+}
+
+Shader::Permutation * Shader::Find(unsigned int mask)
+{
+	unsigned int capacityMask = (unsigned int)m_Permutations.size() - 1;
+	for (unsigned int i = HashMask(mask) & capacityMask; m_Permutations[i].occupied; i = (i + 1) & capacityMask) {
+		if (m_Permutations[i].mask == mask)
+			return &m_Permutations[i];
+	}
+	return nullptr;
+}
+
+Shader::Permutation & Shader::Insert(unsigned int mask)
+{
+	// keep the load factor under 3/4 so probe sequences stay short
+	if ((m_PermutationCount + 1) * 4 > m_Permutations.size() * 3) {
+		std::vector<Permutation> old(m_Permutations.size() * 2);
+		old.swap(m_Permutations);
+
+		unsigned int capacityMask = (unsigned int)m_Permutations.size() - 1;
+		for (auto& permutation : old) {
+			if (!permutation.occupied)
+				continue;
+			unsigned int i = HashMask(permutation.mask) & capacityMask;
+			while (m_Permutations[i].occupied)
+				i = (i + 1) & capacityMask;
+			m_Permutations[i] = std::move(permutation);	// the uniform tables are heap allocated, m_Bound stays valid
+		}
+	}
+
+	unsigned int capacityMask = (unsigned int)m_Permutations.size() - 1;
+	unsigned int i = HashMask(mask) & capacityMask;
+	while (m_Permutations[i].occupied)
+		i = (i + 1) & capacityMask;
+
+	m_Permutations[i] = { mask, 0, 0, 0, 0, true, nullptr };
+	m_PermutationCount++;
+	return m_Permutations[i];
+}
+
+std::vector<ShaderDefine> Shader::GetDefines(unsigned int mask) const
+{
+	std::vector<ShaderDefine> defines(m_Defines);
+	for (unsigned int i = 0; i < m_Keywords.size(); i++) {
+		if (mask & (1u << i))
+			defines.push_back({ m_Keywords[i], "1" });
+	}
+	return defines;
+}
+
+ProgramHandle Shader::Build(unsigned int mask)
+{
+	PreprocessedShader source;
+	if (!m_Preprocessor.Process(m_Filepath, GetDefines(mask), source))
+		return ~0u;		// never valid, so we don't retry every frame
+	return Submit(source);
+}
+
+ProgramHandle Shader::Submit(const PreprocessedShader & source)
+{
+	if (source.GetDependencies() != m_Dependencies) {
+		m_Dependencies = source.GetDependencies();
+		m_DependencyVersion++;
+		s_DependencyEpoch++;
+	}
+	return m_Compiler.Submit(source.GetStages());
+}
+
+bool Shader::Resolve(Permutation & permutation)
+{
+	if (permutation.program)
+		return true;
+	if (0 == permutation.handle)
+		permutation.handle = Build(permutation.mask);
+
+	switch (m_Compiler.GetStatus(permutation.handle))
+	{
+		case ProgramStatus::READY:
+			permutation.program = m_Compiler.TakeProgram(permutation.handle);
+			permutation.uniforms.reset(new UniformTable(permutation.program));
+			return true;
+		default:
+			return false;	// still compiling, or failed (the compiler has printed why)
+	}
+}
+
+Shader::Permutation * Shader::Acquire(unsigned int mask)
+{
+	Permutation* permutation = Find(mask);
+	if (!permutation)
+		permutation = &Insert(mask);
+
+	permutation->uses++;
+	return Resolve(*permutation) ? permutation : nullptr;
+}
+
+unsigned int Shader::GetProgram(unsigned int mask)
+{
+	Permutation* permutation = Acquire(mask);
+	return permutation ? permutation->program : 0;
+}
+
+bool Shader::Bind(unsigned int mask)
+{
+	Permutation* permutation = Acquire(mask);
+	if (!permutation)
+		return false;
+
+	GLStateCache::Get().UseProgram(permutation->program);
+	m_Bound = permutation->uniforms.get();
+	return true;
+}
+
+void Shader::Unbind()
+{
+	GLStateCache::Get().UseProgram(0);
+	m_Bound = nullptr;
+}
+
+int Shader::GetUniformLocation(const UniformName & name)
+{
+	ASSERT(m_Bound);
+	return m_Bound->GetLocation(name);
+}
+
+void Shader::SetUniform(const UniformName & name, int value)
+{
+	ASSERT(m_Bound);
+	int location = m_Bound->Set(name, &value, sizeof(value));
+	if (-1 != location) {
+		GLCall(glUniform1i(location, value));
+	}
+}
+
+void Shader::SetUniform(const UniformName & name, float value)
+{
+	ASSERT(m_Bound);
+	int location = m_Bound->Set(name, &value, sizeof(value));
+	if (-1 != location) {
+		GLCall(glUniform1f(location, value));
+	}
+}
+
+void Shader::SetUniform(const UniformName & name, float x, float y)
+{
+	ASSERT(m_Bound);
+	const float value[] = { x, y };
+	int location = m_Bound->Set(name, value, sizeof(value));
+	if (-1 != location) {
+		GLCall(glUniform2f(location, x, y));
+	}
+}
+
+void Shader::SetUniform(const UniformName & name, float x, float y, float z)
+{
+	ASSERT(m_Bound);
+	const float value[] = { x, y, z };
+	int location = m_Bound->Set(name, value, sizeof(value));
+	if (-1 != location) {
+		GLCall(glUniform3f(location, x, y, z));
+	}
+}
+
+void Shader::SetUniform(const UniformName & name, float x, float y, float z, float w)
+{
+	ASSERT(m_Bound);
+	const float value[] = { x, y, z, w };
+	int location = m_Bound->Set(name, value, sizeof(value));
+	if (-1 != location) {
+		GLCall(glUniform4f(location, x, y, z, w));
+	}
+}
+
+void Shader::SetUniformMat3(const UniformName & name, const float * matrix)
+{
+	ASSERT(m_Bound);
+	int location = m_Bound->Set(name, matrix, 9 * sizeof(float));
+	if (-1 != location) {
+		GLCall(glUniformMatrix3fv(location, 1, GL_FALSE, matrix));
+	}
+}
+
+void Shader::SetUniformMat4(const UniformName & name, const float * matrix)
+{
+	ASSERT(m_Bound);
+	int location = m_Bound->Set(name, matrix, 16 * sizeof(float));
+	if (-1 != location) {
+		GLCall(glUniformMatrix4fv(location, 1, GL_FALSE, matrix));
+	}
+}
+
+void Shader::SetUniformBlockBinding(const char * block, unsigned int bindingPoint)
+{
+	ASSERT(m_Bound);
+	GLCall(unsigned int index = glGetUniformBlockIndex(m_Bound->GetProgram(), block));
+	if (GL_INVALID_INDEX != index) {
+		GLCall(glUniformBlockBinding(m_Bound->GetProgram(), index, bindingPoint));
+	}
+}
+
+void Shader::Prewarm(const std::vector<unsigned int>& masks)
+{
+	for (unsigned int mask : masks) {
+		if (!Find(mask))
+			Insert(mask);
+		if (std::find(m_Prewarm.begin(), m_Prewarm.end(), mask) == m_Prewarm.end())
+			m_Prewarm.push_back(mask);
+	}
+
+	// most used at the back, Update() pops from there
+	std::sort(m_Prewarm.begin(), m_Prewarm.end(), [this](unsigned int a, unsigned int b) {
+		return Find(a)->uses < Find(b)->uses;
+	});
+}
+
+void Shader::Update(unsigned int budget)
+{
+	while (budget > 0 && !m_Prewarm.empty()) {
+		Permutation* permutation = Find(m_Prewarm.back());
+		m_Prewarm.pop_back();
+
+		if (0 == permutation->handle) {
+			permutation->handle = Build(permutation->mask);
+			budget--;
+		}
+	}
+
+	if (0 == m_PendingReloads)
+		return;
+
+	// swap reloaded programs in between frames, nothing is bound now
+	for (auto& permutation : m_Permutations) {
+		if (!permutation.occupied || 0 == permutation.reloadHandle)
+			continue;
+
+		switch (m_Compiler.GetStatus(permutation.reloadHandle))
+		{
+			case ProgramStatus::PENDING:
+				break;
+			case ProgramStatus::READY:
+				if (m_Bound == permutation.uniforms.get())
+					m_Bound = nullptr;
+				GLStateCache::Get().DeleteProgram(permutation.program);
+				permutation.program = m_Compiler.TakeProgram(permutation.reloadHandle);
+				permutation.uniforms.reset(new UniformTable(permutation.program));
+				permutation.handle = permutation.reloadHandle;
+				permutation.reloadHandle = 0;
+				m_PendingReloads--;
+				std::cout << "Reloaded " << m_Filepath << " (permutation " << permutation.mask << ")" << std::endl;
+				break;
+			default:
+				std::cout << "Reloading " << m_Filepath << " failed, keeping the previous version" << std::endl;
+				m_Compiler.Discard(permutation.reloadHandle);
+				permutation.reloadHandle = 0;
+				m_PendingReloads--;
+				break;
+		}
+	}
+}
+
+void Shader::Reload()
+{
+	for (unsigned int mask : GetBuiltMasks()) {
+		PreprocessedShader source;
+		if (m_Preprocessor.Process(m_Filepath, GetDefines(mask), source))
+			Reload(mask, source);
+		else
+			std::cout << "Reloading " << m_Filepath << " failed, keeping the previous version" << std::endl;
+	}
+}
+
+void Shader::Reload(unsigned int mask, const PreprocessedShader & source)
+{
+	Permutation* permutation = Find(mask);
+	if (!permutation || 0 == permutation->handle)
+		return;		// never asked for, it'll be built from the new source when it is
+
+	if (permutation->program) {
+		// a newer edit replaces a rebuild that hasn't finished yet
+		if (permutation->reloadHandle)
+			m_Compiler.Discard(permutation->reloadHandle);
+		else
+			m_PendingReloads++;
+		permutation->reloadHandle = Submit(source);
+	}
+	else {
+		// the last build failed, or the first one is still compiling: either way the new source replaces it
+		m_Compiler.Discard(permutation->handle);
+		permutation->handle = Submit(source);
+	}
+}
+
+std::vector<unsigned int> Shader::GetBuiltMasks() const
+{
+	std::vector<unsigned int> masks;
+	for (const auto& permutation : m_Permutations) {
+		if (permutation.occupied && permutation.handle)
+			masks.push_back(permutation.mask);
+	}
+	return masks;
+}
+
+bool Shader::SaveUsage(const std::string & filepath) const
+{
+	std::ofstream stream(filepath, std::ios::trunc);
+	if (!stream)
+		return false;
+
+	for (const auto& permutation : m_Permutations) {
+		if (permutation.occupied && permutation.uses > 0)
+			stream << permutation.mask << " " << permutation.uses << '\n';
+	}
+	return true;
+}
+
+bool Shader::LoadUsage(const std::string & filepath)
+{
+	std::ifstream stream(filepath);
+	if (!stream)
+		return false;
+
+	std::vector<unsigned int> masks;
+	unsigned int mask, uses;
+	while (stream >> mask >> uses) {
+		Permutation* permutation = Find(mask);
+		if (!permutation)
+			permutation = &Insert(mask);
+		permutation->uses += uses;
+		masks.push_back(mask);
+	}
+
+	Prewarm(masks);
+	return true;
+}
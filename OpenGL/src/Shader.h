@@ -0,0 +1,107 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "ShaderCompiler.h"
+#include "ShaderPreprocessor.h"
+#include "UniformTable.h"
+
+// a .shader file plus a set of keywords (feature toggles such as "TEXTURED", "SKINNED", "FOG"). Every combination
+// of keywords is a permutation, selected by a bitmask (bit i = keyword i), and compiled with "#define <keyword> 1"
+// for each bit that is set. A permutation is only compiled the first time a draw asks for it.
+class Shader
+{
+private:
+	struct Permutation {
+		unsigned int mask;
+		ProgramHandle handle;		// the first build, stale once its program has been taken (non-zero means built)
+		ProgramHandle reloadHandle;	// a rebuild after a source change, swapped in by Update() once it's ready
+		unsigned int program;		// opengl id, 0 until the compiler finished
+		unsigned int uses;			// number of times a draw asked for this permutation
+		bool occupied;
+		std::unique_ptr<UniformTable> uniforms;		// reflected once the program is ready
+	};
+
+	std::string m_Filepath;
+	std::vector<std::string> m_Keywords;
+	std::vector<ShaderDefine> m_Defines;		// set in every permutation (limits and such, not toggles)
+	ShaderPreprocessor& m_Preprocessor;
+	ShaderCompiler& m_Compiler;
+
+	// open addressing hash table keyed by mask, capacity is a power of two
+	std::vector<Permutation> m_Permutations;
+	unsigned int m_PermutationCount;
+	std::vector<unsigned int> m_Prewarm;	// masks waiting to be submitted by Update()
+	UniformTable* m_Bound;					// uniforms of the permutation passed to the last Bind()
+	std::vector<std::string> m_Dependencies;	// the .shader file and everything it includes
+	unsigned int m_DependencyVersion;			// bumped whenever m_Dependencies changes
+	unsigned int m_PendingReloads;				// permutations with a reloadHandle
+
+	static unsigned int s_DependencyEpoch;		// bumped whenever any shader's dependencies change
+
+	Permutation* Find(unsigned int mask);
+	Permutation& Insert(unsigned int mask);
+	/* preprocesses and submits the permutation's source, an invalid handle if preprocessing failed */
+	ProgramHandle Build(unsigned int mask);
+	/* submits preprocessed source, picking up its dependencies */
+	ProgramHandle Submit(const PreprocessedShader& source);
+	bool Resolve(Permutation& permutation);
+	/* counts the use, nullptr until the permutation is ready */
+	Permutation* Acquire(unsigned int mask);
+
+public:
+	/* at most 32 keywords. defines are added to every permutation */
+	Shader(const std::string& filepath, const std::vector<std::string>& keywords, ShaderPreprocessor& preprocessor, ShaderCompiler& compiler,
+		const std::vector<ShaderDefine>& defines = {});
+	~Shader();
+
+	/* 0 if the keyword isn't declared */
+	unsigned int GetKeywordMask(const std::string& keyword) const;
+
+	/* compiles the permutation on first use. Returns 0 while it is compiling (or if it failed), skip the draw then */
+	unsigned int GetProgram(unsigned int mask);
+	/* glUseProgram on the permutation, false if it isn't ready yet */
+	bool Bind(unsigned int mask);
+	void Unbind();
+
+	// uniforms of the bound permutation - only valid between Bind() and Unbind(). An upload is skipped when the value
+	// is the same as the last one set on that permutation. Names can be hashed at compile time, see UniformName
+	int GetUniformLocation(const UniformName& name);
+	void SetUniform(const UniformName& name, int value);
+	void SetUniform(const UniformName& name, float value);
+	void SetUniform(const UniformName& name, float x, float y);
+	void SetUniform(const UniformName& name, float x, float y, float z);
+	void SetUniform(const UniformName& name, float x, float y, float z, float w);
+	/* column major */
+	void SetUniformMat3(const UniformName& name, const float* matrix);
+	void SetUniformMat4(const UniformName& name, const float* matrix);
+	/* points a uniform block at a binding point, for shaders that can't use layout(binding = n) */
+	void SetUniformBlockBinding(const char* block, unsigned int bindingPoint);
+
+	/* queue permutations to be compiled ahead of use, most used first (see LoadUsage) */
+	void Prewarm(const std::vector<unsigned int>& masks);
+	/* call once a frame, outside Bind()/Unbind(): swaps in reloaded programs that finished building and
+	   submits up to budget queued permutations so prewarming is spread out */
+	void Update(unsigned int budget = 1);
+
+	/* rebuilds every permutation that has been used from the current sources. Each one keeps drawing with its old
+	   program until the new one is ready, and keeps it for good if the new one fails to compile. The sources are read
+	   on this thread, ShaderWatcher preprocesses on its own and hands the result to Reload(mask, source) instead */
+	void Reload();
+	/* the same for one permutation, from source preprocessed elsewhere (with GetDefines(mask)) */
+	void Reload(unsigned int mask, const PreprocessedShader& source);
+	/* permutations that have been built, the ones Reload() rebuilds */
+	std::vector<unsigned int> GetBuiltMasks() const;
+	/* what the permutation is preprocessed with: the shader's defines plus its keywords */
+	std::vector<ShaderDefine> GetDefines(unsigned int mask) const;
+	inline const std::vector<std::string>& GetDependencies() const { return m_Dependencies; }
+	inline unsigned int GetDependencyVersion() const { return m_DependencyVersion; }
+	static inline unsigned int GetDependencyEpoch() { return s_DependencyEpoch; }
+
+	/* per-permutation use counts, so the next run can prewarm what this one actually drew with */
+	bool SaveUsage(const std::string& filepath) const;
+	bool LoadUsage(const std::string& filepath);
+
+	inline const std::string& GetFilepath() const { return m_Filepath; }
+	inline unsigned int GetPermutationCount() const { return m_PermutationCount; }
+};
@@ -0,0 +1,189 @@
+#include "ShaderCache.h"
+#include "Renderer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+namespace {
+
+	const unsigned int CacheMagic = 0x42504c47;		// "GLPB"
+	const unsigned int CacheVersion = 1;
+	const unsigned int MaxBinaryLength = 64 * 1024 * 1024;	// anything bigger is a corrupt header, not a program
+
+	// written in front of every binary blob
+	struct CacheHeader {
+		unsigned int magic;
+		unsigned int version;
+		unsigned long long key;		// guards against a hash collision on the file name
+		unsigned int format;		// binary format returned by glGetProgramBinary
+		unsigned int length;
+		double buildMs;				// what it cost to build this program from source
+	};
+
+	// 64 bit FNV-1a
+	unsigned long long Hash(const char* data, size_t length, unsigned long long hash = 14695981039346656037ull)
+	{
+		for (size_t i = 0; i < length; i++) {
+			hash ^= (unsigned char)data[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	unsigned long long Hash(const GLubyte* str, unsigned long long hash)
+	{
+		const char* s = str ? (const char*)str : "";
+		// include the terminator so that "ab"+"c" and "a"+"bc" hash differently
+		return Hash(s, strlen(s) + 1, hash);
+	}
+
+	void MakeDirectory(const std::string& path)
+	{
+#ifdef _WIN32
+		_mkdir(path.c_str());
+#else
+		mkdir(path.c_str(), 0755);
+#endif
+	}
+
+	double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+ShaderCache::ShaderCache(const std::string & directory)
+	: m_Directory(directory), m_DriverHash(0), m_Supported(false),
+	m_Hits(0), m_Misses(0), m_Rejected(0), m_LoadMs(0.0), m_SavedMs(0.0), m_BuildMs(0.0)
+{
+	m_DriverHash = Hash(glGetString(GL_VENDOR), 14695981039346656037ull);
+	m_DriverHash = Hash(glGetString(GL_RENDERER), m_DriverHash);
+	m_DriverHash = Hash(glGetString(GL_VERSION), m_DriverHash);
+
+	if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary) {
+		int formats = 0;
+		GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+		m_Supported = formats > 0;	// some drivers advertise the extension but accept no formats
+		if (m_Supported) {
+			m_Formats.resize(formats);
+			GLCall(glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, m_Formats.data()));
+		}
+	}
+
+	if (m_Supported)
+		MakeDirectory(m_Directory);
+}
+
+std::string ShaderCache::GetPath(unsigned long long key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", key);
+	return m_Directory + "/" + name;
+}
+
+unsigned long long ShaderCache::ComputeKey(const std::vector<ShaderStageSource>& stages) const
+{
+	unsigned long long key = m_DriverHash;
+	for (const auto& stage : stages) {
+		key = Hash((const char*)&stage.type, sizeof(stage.type), key);
+		key = Hash(stage.source.data, stage.source.length, key);
+	}
+	return key;
+}
+
+unsigned int ShaderCache::Load(unsigned long long key)
+{
+	if (!m_Supported) {
+		m_Misses++;
+		return 0;
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::ifstream stream(GetPath(key), std::ios::binary);
+	CacheHeader header;
+	if (!stream.read((char*)&header, sizeof(header))
+		|| header.magic != CacheMagic || header.version != CacheVersion || header.key != key
+		|| 0 == header.length || header.length > MaxBinaryLength) {
+		m_Misses++;
+		return 0;
+	}
+
+	// a driver update can drop the format the binary was saved in, glProgramBinary would fail with GL_INVALID_ENUM
+	if (std::find(m_Formats.begin(), m_Formats.end(), (int)header.format) == m_Formats.end()) {
+		m_Rejected++;
+		m_Misses++;
+		return 0;
+	}
+
+	std::vector<char> binary(header.length);
+	if (!stream.read(binary.data(), header.length)) {
+		m_Misses++;
+		return 0;
+	}
+
+	unsigned int program = glCreateProgram();
+	GLCall(glProgramBinary(program, header.format, binary.data(), header.length));
+
+	int linked;
+	GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+	if (GL_FALSE == linked) {
+		// the driver may reject a binary at any time (e.g. after an update that kept the version string)
+		GLCall(glDeleteProgram(program));
+		m_Rejected++;
+		m_Misses++;
+		return 0;
+	}
+
+	double loadMs = MillisecondsSince(start);
+	m_Hits++;
+	m_LoadMs += loadMs;
+	m_SavedMs += header.buildMs - loadMs;
+	return program;
+}
+
+void ShaderCache::Store(unsigned long long key, unsigned int program, double buildMs)
+{
+	m_BuildMs += buildMs;
+	if (!m_Supported)
+		return;
+
+	int length = 0;
+	GLCall(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+	if (length <= 0)
+		return;
+
+	std::vector<char> binary(length);
+	GLenum format;
+	GLCall(glGetProgramBinary(program, length, &length, &format, binary.data()));
+
+	CacheHeader header = { CacheMagic, CacheVersion, key, format, (unsigned int)length, buildMs };
+
+	// write to a temporary and rename so that a crash mid-write never leaves a truncated entry behind
+	std::string path = GetPath(key);
+	std::string temp = path + ".tmp";
+	{
+		std::ofstream stream(temp, std::ios::binary | std::ios::trunc);
+		stream.write((const char*)&header, sizeof(header));
+		stream.write(binary.data(), length);
+		if (!stream) {
+			std::cout << "Shader cache: failed to write " << temp << std::endl;
+			return;
+		}
+	}
+	std::remove(path.c_str());	// rename won't replace an existing file on windows
+	std::rename(temp.c_str(), path.c_str());
+}
+
+void ShaderCache::PrintStats() const
+{
+	std::cout << "Shader cache: " << m_Hits << " hits, " << m_Misses << " misses (" << m_Rejected << " rejected), "
+		<< m_LoadMs << "ms loading, " << m_BuildMs << "ms building, ~" << m_SavedMs << "ms saved" << std::endl;
+}
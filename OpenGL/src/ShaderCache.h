@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "ShaderParser.h"
+
+// on-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary) so that later launches
+// can skip compiling and linking from source. Entries are keyed by a hash of the (preprocessed) sources plus
+// the driver vendor/renderer/version strings, so a driver update simply misses and rebuilds.
+class ShaderCache
+{
+private:
+	std::string m_Directory;
+	unsigned long long m_DriverHash;	// hash of GL_VENDOR, GL_RENDERER and GL_VERSION
+	bool m_Supported;					// false if the context exposes no program binary formats
+	std::vector<int> m_Formats;			// GL_PROGRAM_BINARY_FORMATS, what glProgramBinary accepts
+
+	unsigned int m_Hits;
+	unsigned int m_Misses;
+	unsigned int m_Rejected;			// binaries found on disk but refused by the driver
+	double m_LoadMs;					// time spent loading hits
+	double m_SavedMs;					// build time recorded with each hit, minus the time it took to load it
+	double m_BuildMs;					// time spent building misses from source
+
+	std::string GetPath(unsigned long long key) const;
+
+public:
+	/* needs a current GL context, the driver strings are read here */
+	ShaderCache(const std::string& directory);
+
+	unsigned long long ComputeKey(const std::vector<ShaderStageSource>& stages) const;
+
+	/* returns a linked program, or 0 on a miss / rejected binary (caller then builds from source) */
+	unsigned int Load(unsigned long long key);
+	/* program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set. buildMs is what the source build cost */
+	void Store(unsigned long long key, unsigned int program, double buildMs);
+
+	inline bool IsSupported() const { return m_Supported; }
+	inline unsigned int GetHits() const { return m_Hits; }
+	inline unsigned int GetMisses() const { return m_Misses; }
+
+	void PrintStats() const;
+};
@@ -0,0 +1,260 @@
+#include "ShaderCompiler.h"
+#include "ShaderCache.h"
+#include "Renderer.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+static const char* GetShaderTypeName(unsigned int type)
+{
+	switch (type)
+	{
+		case GL_VERTEX_SHADER:			return "vertex";
+		case GL_FRAGMENT_SHADER:		return "fragment";
+		case GL_GEOMETRY_SHADER:		return "geometry";
+		case GL_TESS_CONTROL_SHADER:	return "tessellation control";
+		case GL_TESS_EVALUATION_SHADER:	return "tessellation evaluation";
+		case GL_COMPUTE_SHADER:			return "compute";
+	}
+	return "unknown";
+}
+
+ShaderCompiler::ShaderCompiler(ShaderCache * cache)
+	: m_Cache(cache), m_Parallel(false), m_Pending(0)
+{
+	// 0xFFFFFFFF lets the driver use as many threads as it likes. GL_COMPLETION_STATUS has the same value for both
+	if (GLEW_KHR_parallel_shader_compile) {
+		m_Parallel = true;
+		GLCall(glMaxShaderCompilerThreadsKHR(0xFFFFFFFF));
+	}
+	else if (GLEW_ARB_parallel_shader_compile) {
+		m_Parallel = true;
+		GLCall(glMaxShaderCompilerThreadsARB(0xFFFFFFFF));
+	}
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+	for (auto& program : m_Programs) {
+		if (ProgramStatus::PENDING == program.status) {
+			for (unsigned int shader : program.shaders) {
+				GLCall(glDeleteShader(shader));
+			}
+			GLCall(glDeleteProgram(program.program));
+		}
+	}
+}
+
+ShaderCompiler::Program * ShaderCompiler::Find(ProgramHandle handle)
+{
+	const unsigned int index = handle & IndexMask;
+	if (0 == index || index > m_Programs.size())
+		return nullptr;
+	Program& program = m_Programs[index - 1];
+	if (ProgramStatus::INVALID == program.status || program.generation != handle >> IndexBits)
+		return nullptr;
+	return &program;
+}
+
+const ShaderCompiler::Program * ShaderCompiler::Find(ProgramHandle handle) const
+{
+	return const_cast<ShaderCompiler*>(this)->Find(handle);
+}
+
+unsigned int ShaderCompiler::Allocate()
+{
+	if (!m_FreeEntries.empty()) {
+		unsigned int index = m_FreeEntries.back();
+		m_FreeEntries.pop_back();
+		return index;
+	}
+	ASSERT(m_Programs.size() < IndexMask);	// ~0u stays invalid
+	m_Programs.push_back({ 0, {}, 0, ProgramStatus::INVALID, 0, false, {} });
+	return (unsigned int)m_Programs.size() - 1;
+}
+
+void ShaderCompiler::Release(unsigned int index)
+{
+	Program& program = m_Programs[index];
+	program.program = 0;
+	program.status = ProgramStatus::INVALID;
+	program.generation = (program.generation + 1) & (~0u >> IndexBits);
+	m_FreeEntries.push_back(index);
+}
+
+ProgramHandle ShaderCompiler::Submit(const std::vector<ShaderStageSource>& stages)
+{
+	const unsigned int index = Allocate();
+	Program& program = m_Programs[index];
+	const ProgramHandle handle = (program.generation << IndexBits) | (index + 1);
+	program.program = 0;
+	program.shaders.clear();
+	program.cacheKey = 0;
+	program.status = ProgramStatus::PENDING;
+	program.discarded = false;
+	program.submitted = std::chrono::high_resolution_clock::now();
+
+	if (m_Cache) {
+		program.cacheKey = m_Cache->ComputeKey(stages);
+
+		if ((program.program = m_Cache->Load(program.cacheKey)) != 0) {
+			program.status = ProgramStatus::READY;
+			return handle;
+		}
+	}
+
+	// queue everything, no status queries here - asking for GL_COMPILE_STATUS now would wait for the compile
+	program.program = glCreateProgram();
+	for (const auto& stage : stages) {
+		// pass the stage as slices of the file with a #line after #version, so errors report lines in the .shader file
+		SourceView head, tail;
+		unsigned int tailLine;
+		SplitAtVersion(stage, head, tail, tailLine);
+
+		char lineDirective[32];
+		snprintf(lineDirective, sizeof(lineDirective), "#line %u 0\n", tailLine);	// source string 0 is the .shader file itself
+		const char* strings[] = { head.data, lineDirective, tail.data };
+		const int lengths[] = { (int)head.length, (int)strlen(lineDirective), (int)tail.length };
+
+		unsigned int id = glCreateShader(stage.type);
+		GLCall(glShaderSource(id, 3, strings, lengths));
+		GLCall(glCompileShader(id));
+		GLCall(glAttachShader(program.program, id));
+		program.shaders.push_back(id);
+	}
+
+	if (m_Cache && m_Cache->IsSupported()) {
+		GLCall(glProgramParameteri(program.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));	// must be set before linking
+	}
+	GLCall(glLinkProgram(program.program));
+
+	m_Pending++;
+	return handle;
+}
+
+void ShaderCompiler::Finish(unsigned int index)
+{
+	Program& program = m_Programs[index];
+	int linked;
+	GLCall(glGetProgramiv(program.program, GL_LINK_STATUS, &linked));
+
+	if (GL_FALSE == linked && !program.discarded) {
+		// only now pay for the info logs
+		for (unsigned int shader : program.shaders) {
+			int compiled;
+			GLCall(glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled));
+			if (GL_TRUE == compiled)
+				continue;
+
+			int type, len;
+			GLCall(glGetShaderiv(shader, GL_SHADER_TYPE, &type));
+			GLCall(glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &len));
+			std::vector<char> errormsg(len + 1);
+			GLCall(glGetShaderInfoLog(shader, len, &len, errormsg.data()));
+			std::cout << "Error compiling " << GetShaderTypeName(type) << " shader" << errormsg.data() << std::endl;
+		}
+
+		int len;
+		GLCall(glGetProgramiv(program.program, GL_INFO_LOG_LENGTH, &len));
+		std::vector<char> errormsg(len + 1);
+		GLCall(glGetProgramInfoLog(program.program, len, &len, errormsg.data()));
+		std::cout << "Error linking program " << errormsg.data() << std::endl;
+	}
+
+	for (unsigned int shader : program.shaders) {
+		GLCall(glDetachShader(program.program, shader));
+		GLCall(glDeleteShader(shader));
+	}
+	program.shaders.clear();
+	m_Pending--;
+
+	if (GL_FALSE == linked || program.discarded) {
+		GLCall(glDeleteProgram(program.program));
+		program.program = 0;
+		program.status = ProgramStatus::FAILED;
+		if (program.discarded)
+			Release(index);		// nobody holds the handle any more
+		return;
+	}
+
+	program.status = ProgramStatus::READY;
+	if (m_Cache) {
+		double buildMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - program.submitted).count();
+		m_Cache->Store(program.cacheKey, program.program, buildMs);
+	}
+}
+
+void ShaderCompiler::Poll()
+{
+	if (0 == m_Pending)
+		return;
+
+	for (unsigned int i = 0; i < m_Programs.size(); i++) {
+		if (ProgramStatus::PENDING != m_Programs[i].status)
+			continue;
+
+		if (m_Parallel) {
+			int completed;
+			GLCall(glGetProgramiv(m_Programs[i].program, GL_COMPLETION_STATUS_KHR, &completed));
+			if (GL_FALSE == completed)
+				continue;
+		}
+		// without the extension there's no way to ask without blocking, so everything submitted finishes here
+		Finish(i);
+	}
+}
+
+void ShaderCompiler::Wait(ProgramHandle handle)
+{
+	Program* program = Find(handle);
+	ASSERT(program);
+	if (ProgramStatus::PENDING == program->status)
+		Finish((unsigned int)(program - m_Programs.data()));
+}
+
+void ShaderCompiler::WaitAll()
+{
+	for (unsigned int i = 0; i < m_Programs.size(); i++) {
+		if (ProgramStatus::PENDING == m_Programs[i].status)
+			Finish(i);
+	}
+}
+
+void ShaderCompiler::Discard(ProgramHandle handle)
+{
+	Program* program = Find(handle);
+	if (!program)
+		return;
+
+	if (ProgramStatus::PENDING == program->status) {
+		program->discarded = true;
+		return;
+	}
+	if (ProgramStatus::READY == program->status) {
+		GLCall(glDeleteProgram(program->program));
+	}
+	Release((unsigned int)(program - m_Programs.data()));
+}
+
+unsigned int ShaderCompiler::TakeProgram(ProgramHandle handle)
+{
+	Program* program = Find(handle);
+	if (!program || ProgramStatus::READY != program->status)
+		return 0;
+
+	unsigned int id = program->program;
+	Release((unsigned int)(program - m_Programs.data()));
+	return id;
+}
+
+ProgramStatus ShaderCompiler::GetStatus(ProgramHandle handle) const
+{
+	const Program* program = Find(handle);
+	return program ? program->status : ProgramStatus::INVALID;
+}
+
+unsigned int ShaderCompiler::GetProgram(ProgramHandle handle) const
+{
+	const Program* program = Find(handle);
+	return program && ProgramStatus::READY == program->status ? program->program : 0;
+}
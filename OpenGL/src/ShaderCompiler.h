@@ -0,0 +1,83 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+#include "ShaderParser.h"
+
+class ShaderCache;
+
+enum class ProgramStatus {
+	INVALID = -1,
+	PENDING = 0,
+	READY = 1,
+	FAILED = 2,
+};
+
+// index into the compiler's program table + 1 in the low bits, the entry's generation above them: entries are reused,
+// and a handle to one that has been reused since is INVALID instead of someone else's program. 0 is never valid
+typedef unsigned int ProgramHandle;
+
+// builds programs without stalling the render thread: Submit() hands every shader and the link to the driver
+// straight away and only Poll() asks for results. With KHR_parallel_shader_compile the driver compiles on its own
+// threads and Poll() only checks GL_COMPLETION_STATUS_KHR, so it never blocks. Info logs are only fetched on failure.
+// An entry is reused once its program has been taken (TakeProgram) or discarded, so the table only ever holds what's
+// in flight and Poll() has that much to walk.
+class ShaderCompiler
+{
+private:
+	struct Program {
+		unsigned int program;				// opengl id
+		std::vector<unsigned int> shaders;	// detached and deleted once the link finished
+		unsigned long long cacheKey;
+		ProgramStatus status;				// INVALID for an unused entry
+		unsigned int generation;			// bumped every time the entry is reused
+		bool discarded;						// nobody wants the result any more, delete it when it finishes
+		std::chrono::high_resolution_clock::time_point submitted;
+	};
+
+	static const unsigned int IndexBits = 20;
+	static const unsigned int IndexMask = (1u << IndexBits) - 1;
+
+	std::vector<Program> m_Programs;
+	std::vector<unsigned int> m_FreeEntries;		// indices into m_Programs
+	ShaderCache* m_Cache;		// optional
+	bool m_Parallel;			// KHR_parallel_shader_compile is available
+	unsigned int m_Pending;
+
+	void Finish(unsigned int index);
+	/* nullptr for a handle that was never valid or whose entry has been reused */
+	Program* Find(ProgramHandle handle);
+	const Program* Find(ProgramHandle handle) const;
+	/* an unused entry, reused or new, returns its index */
+	unsigned int Allocate();
+	/* puts the entry back for Allocate(), its handles become invalid */
+	void Release(unsigned int index);
+
+public:
+	ShaderCompiler(ShaderCache* cache = nullptr);
+	/* deletes programs that are still pending, ready ones belong to the caller (take or discard them) */
+	~ShaderCompiler();
+
+	/* the sources are only read during the call */
+	ProgramHandle Submit(const std::vector<ShaderStageSource>& stages);
+
+	/* never blocks when the driver supports parallel compilation */
+	void Poll();
+	/* blocks until the program finished linking */
+	void Wait(ProgramHandle handle);
+	void WaitAll();
+
+	/* the caller no longer wants the program: deletes it, or arranges for it to be deleted once it finishes. The handle
+	   is invalid afterwards */
+	void Discard(ProgramHandle handle);
+	/* hands a ready program over to the caller, who deletes it: 0 if it isn't ready. The handle is invalid afterwards */
+	unsigned int TakeProgram(ProgramHandle handle);
+
+	ProgramStatus GetStatus(ProgramHandle handle) const;
+	/* returns 0 until the program is ready, draws that need it should be skipped (or use a fallback) until then. The
+	   compiler still owns it, see TakeProgram */
+	unsigned int GetProgram(ProgramHandle handle) const;
+
+	inline bool IsParallel() const { return m_Parallel; }
+	inline unsigned int GetPendingCount() const { return m_Pending; }
+};
@@ -0,0 +1,152 @@
+#include "ShaderParser.h"
+#include "Renderer.h"
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+	struct StageName {
+		const char* name;
+		unsigned int type;
+	};
+
+	const StageName StageNames[] = {
+		{ "vertex",				GL_VERTEX_SHADER },
+		{ "fragment",			GL_FRAGMENT_SHADER },
+		{ "geometry",			GL_GEOMETRY_SHADER },
+		{ "tesscontrol",		GL_TESS_CONTROL_SHADER },
+		{ "tess_control",		GL_TESS_CONTROL_SHADER },
+		{ "tessevaluation",		GL_TESS_EVALUATION_SHADER },
+		{ "tess_evaluation",	GL_TESS_EVALUATION_SHADER },
+		{ "compute",			GL_COMPUTE_SHADER },
+	};
+
+	inline bool IsBlank(char c) { return ' ' == c || '\t' == c; }
+}
+
+const char* NextLine(const char* line, const char* end)
+{
+	const char* newline = (const char*)memchr(line, '\n', end - line);
+	return newline ? newline + 1 : end;
+}
+
+bool StartsWithDirective(const char*& p, const char* lineEnd, const char* directive, size_t length)
+{
+	while (p < lineEnd && IsBlank(*p))
+		p++;
+	if ((size_t)(lineEnd - p) < length || 0 != memcmp(p, directive, length))
+		return false;
+	p += length;
+	return true;
+}
+
+unsigned int GetShaderTypeFromName(const char * name, size_t length)
+{
+	for (const auto& stage : StageNames) {
+		if (strlen(stage.name) == length && 0 == memcmp(stage.name, name, length))
+			return stage.type;
+	}
+	return 0;
+}
+
+bool ShaderFile::Load(const std::string & filepath)
+{
+	m_Path = filepath;
+	m_Buffer.clear();
+	m_Stages.clear();
+
+	// one read for the whole file
+	std::ifstream stream(filepath, std::ios::binary | std::ios::ate);
+	if (!stream) {
+		std::cout << "Failed to open shader " << filepath << std::endl;
+		return false;
+	}
+	std::streamoff size = stream.tellg();
+	stream.seekg(0);
+
+	if (size > 0) {
+		m_Buffer.resize((size_t)size);
+		stream.read(m_Buffer.data(), size);
+		m_Buffer.resize((size_t)stream.gcount());
+	}
+
+	Parse(m_Buffer.data(), m_Buffer.size());
+	return true;
+}
+
+void ShaderFile::Parse(const char * data, size_t length)
+{
+	m_Stages.clear();
+
+	const char* end = data + length;
+	const char* line = data;
+	unsigned int lineNumber = 1;
+	ShaderStageSource* current = nullptr;
+
+	// lines are only delimited (memchr is vectorised), nothing is copied
+	while (line < end) {
+		const char* next = NextLine(line, end);
+		const char* p = line;
+
+		if (StartsWithDirective(p, next, "#shader", 7)) {
+			// close off the stage we were in, it ends where this line starts
+			if (current)
+				current->source.length = line - current->source.data;
+			current = nullptr;
+
+			while (p < next && IsBlank(*p))
+				p++;
+			const char* name = p;
+			while (p < next && (isalnum((unsigned char)*p) || '_' == *p))
+				p++;
+
+			if (unsigned int type = GetShaderTypeFromName(name, p - name)) {
+				m_Stages.push_back({ type, { next, 0 }, lineNumber + 1 });
+				current = &m_Stages.back();
+			}
+			else {
+				std::cout << "Unknown shader stage '" << std::string(name, p - name) << "' in " << m_Path << ": " << lineNumber << std::endl;
+			}
+		}
+
+		line = next;
+		lineNumber++;
+	}
+
+	if (current)
+		current->source.length = end - current->source.data;
+}
+
+const ShaderStageSource * ShaderFile::GetStage(unsigned int type) const
+{
+	for (const auto& stage : m_Stages) {
+		if (stage.type == type)
+			return &stage;
+	}
+	return nullptr;
+}
+
+void SplitAtVersion(const ShaderStageSource & stage, SourceView & head, SourceView & tail, unsigned int & tailLine)
+{
+	const char* begin = stage.source.data;
+	const char* end = begin + stage.source.length;
+	unsigned int lineNumber = stage.firstLine;
+
+	for (const char* line = begin; line < end; lineNumber++) {
+		const char* next = NextLine(line, end);
+		const char* p = line;
+		if (StartsWithDirective(p, next, "#version", 8)) {
+			head = { begin, (size_t)(next - begin) };
+			tail = { next, (size_t)(end - next) };
+			tailLine = lineNumber + 1;
+			return;
+		}
+		line = next;
+	}
+
+	head = { begin, 0 };
+	tail = stage.source;
+	tailLine = stage.firstLine;
+}
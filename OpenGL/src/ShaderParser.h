@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// non-owning slice of a buffer (VS2015 has no std::string_view)
+struct SourceView {
+	const char* data;
+	size_t length;
+
+	inline std::string ToString() const { return std::string(data, length); }
+};
+
+struct ShaderStageSource {
+	unsigned int type;			// GL_VERTEX_SHADER, GL_FRAGMENT_SHADER...
+	SourceView source;			// must outlive the compile
+	unsigned int firstLine;		// line in the original file the source starts on, so driver errors point at the right line
+};
+
+// a .shader file holding any number of stages, each one introduced by a "#shader <stage>" line:
+//   #shader vertex / fragment / geometry / tesscontrol / tessevaluation / compute
+// the file is read in one go and parsed in a single pass, the stages are slices of that buffer so nothing is copied.
+class ShaderFile
+{
+private:
+	std::string m_Path;
+	std::vector<char> m_Buffer;
+	std::vector<ShaderStageSource> m_Stages;
+
+public:
+	/* reads and parses the file, returns false if it couldn't be read */
+	bool Load(const std::string& filepath);
+	/* parses text that's already in memory, the views point into data so it must stay alive */
+	void Parse(const char* data, size_t length);
+
+	inline const std::string& GetPath() const { return m_Path; }
+	inline const std::vector<ShaderStageSource>& GetStages() const { return m_Stages; }
+	/* returns nullptr if the file has no stage of that type */
+	const ShaderStageSource* GetStage(unsigned int type) const;
+};
+
+/* maps a "#shader" stage name to its GL enum, 0 if unknown */
+unsigned int GetShaderTypeFromName(const char* name, size_t length);
+
+/* splits a stage so a "#line" directive can go straight after its #version line (nothing may precede #version).
+   head is everything up to and including the #version line (empty if there is none), tailLine is the line tail starts on */
+void SplitAtVersion(const ShaderStageSource& stage, SourceView& head, SourceView& tail, unsigned int& tailLine);
+
+/* returns the start of the line after line (or end) */
+const char* NextLine(const char* line, const char* end);
+/* true if the line starts with directive (leading blanks allowed), p is left just after it */
+bool StartsWithDirective(const char*& p, const char* lineEnd, const char* directive, size_t length);
@@ -0,0 +1,195 @@
+#include "ShaderPreprocessor.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/stat.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace {
+
+	const int MaxIncludeDepth = 32;
+
+	std::string GetDirectory(const std::string& filepath)
+	{
+		size_t slash = filepath.find_last_of("/\\");
+		return std::string::npos == slash ? std::string() : filepath.substr(0, slash + 1);
+	}
+
+	void AppendLineDirective(std::string& out, unsigned int line, unsigned int fileIndex)
+	{
+		if (!out.empty() && '\n' != out.back())
+			out += '\n';
+		out += "#line " + std::to_string(line) + " " + std::to_string(fileIndex) + "\n";
+	}
+}
+
+bool GetFileStamp(const std::string & filepath, FileStamp & stamp)
+{
+#ifdef _WIN32
+	// _stat64 only has whole seconds, the last write time is in 100ns steps
+	WIN32_FILE_ATTRIBUTE_DATA info;
+	if (!GetFileAttributesExA(filepath.c_str(), GetFileExInfoStandard, &info))
+		return false;
+	stamp.modified = (long long)(((unsigned long long)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime) * 100;
+	stamp.size = (long long)(((unsigned long long)info.nFileSizeHigh << 32) | info.nFileSizeLow);
+#else
+	struct stat info;
+	if (0 != stat(filepath.c_str(), &info))
+		return false;
+#ifdef __APPLE__
+	stamp.modified = (long long)info.st_mtimespec.tv_sec * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+	stamp.modified = (long long)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+	stamp.size = (long long)info.st_size;
+#endif
+	return true;
+}
+
+std::vector<ShaderStageSource> PreprocessedShader::GetStages() const
+{
+	std::vector<ShaderStageSource> stages;
+	stages.reserve(m_Stages.size());
+	for (const auto& stage : m_Stages)
+		stages.push_back({ stage.type, { stage.source.data(), stage.source.size() }, stage.firstLine });
+	return stages;
+}
+
+ShaderPreprocessor::ShaderPreprocessor()
+	: m_Reads(0), m_CacheHits(0)
+{
+}
+
+const ShaderPreprocessor::CachedFile * ShaderPreprocessor::GetFile(const std::string & filepath)
+{
+	FileStamp stamp;
+	if (!GetFileStamp(filepath, stamp)) {
+		m_Files.erase(filepath);
+		return nullptr;
+	}
+
+	auto it = m_Files.find(filepath);
+	if (it != m_Files.end() && it->second.stamp == stamp) {
+		m_CacheHits++;
+		return &it->second;
+	}
+
+	std::ifstream stream(filepath, std::ios::binary);
+	if (!stream)
+		return nullptr;
+	std::stringstream contents;
+	contents << stream.rdbuf();
+	m_Reads++;
+
+	CachedFile& file = m_Files[filepath];
+	file.stamp = stamp;
+	file.contents = contents.str();
+	return &file;
+}
+
+bool ShaderPreprocessor::Expand(const char * data, size_t length, const std::string & filepath, unsigned int fileIndex, unsigned int firstLine,
+	std::string & out, std::unordered_set<std::string>& included, PreprocessedShader & shader, int depth)
+{
+	const char* end = data + length;
+	const char* run = data;		// start of the text not yet copied to out
+	unsigned int lineNumber = firstLine;
+
+	for (const char* line = data; line < end; lineNumber++) {
+		const char* next = NextLine(line, end);
+		const char* p = line;
+
+		if (!StartsWithDirective(p, next, "#include", 8)) {
+			line = next;
+			continue;
+		}
+
+		// #include "file" or #include <file>
+		const char* open = std::find_if(p, next, [](char c) { return '"' == c || '<' == c; });
+		const char* close = open < next ? std::find(open + 1, next, '"' == *open ? '"' : '>') : next;
+		if (close >= next) {
+			std::cout << "Malformed #include in " << filepath << ": " << lineNumber << std::endl;
+			return false;
+		}
+
+		out.append(run, line - run);
+		run = next;
+
+		std::string includePath = GetDirectory(filepath) + std::string(open + 1, close);
+		if (included.insert(includePath).second) {
+			if (depth >= MaxIncludeDepth) {
+				std::cout << "#include nested too deeply in " << filepath << ": " << lineNumber << std::endl;
+				return false;
+			}
+
+			const CachedFile* file = GetFile(includePath);
+			if (!file) {
+				std::cout << "Failed to open " << includePath << " included from " << filepath << ": " << lineNumber << std::endl;
+				return false;
+			}
+
+			auto& dependencies = shader.m_Dependencies;
+			unsigned int index = (unsigned int)(std::find(dependencies.begin(), dependencies.end(), includePath) - dependencies.begin());
+			if (index == dependencies.size())
+				dependencies.push_back(includePath);
+
+			AppendLineDirective(out, 1, index);
+			if (!Expand(file->contents.data(), file->contents.size(), includePath, index, 1, out, included, shader, depth + 1))
+				return false;
+		}
+
+		// carry on counting lines of this file
+		AppendLineDirective(out, lineNumber + 1, fileIndex);
+		line = next;
+	}
+
+	out.append(run, end - run);
+	return true;
+}
+
+bool ShaderPreprocessor::Process(const std::string & filepath, const std::vector<ShaderDefine>& defines, PreprocessedShader & shader)
+{
+	shader.m_Stages.clear();
+	shader.m_Dependencies.clear();
+	shader.m_Dependencies.push_back(filepath);
+
+	const CachedFile* file = GetFile(filepath);
+	if (!file) {
+		std::cout << "Failed to open shader " << filepath << std::endl;
+		return false;
+	}
+
+	ShaderFile parsed;
+	parsed.Parse(file->contents.data(), file->contents.size());
+
+	std::string defineBlock;
+	for (const auto& define : defines)
+		defineBlock += "#define " + define.name + " " + define.value + "\n";
+
+	for (const auto& stage : parsed.GetStages()) {
+		SourceView head, tail;
+		unsigned int tailLine;
+		SplitAtVersion(stage, head, tail, tailLine);
+
+		PreprocessedShader::Stage out;
+		out.type = stage.type;
+		out.firstLine = stage.firstLine;
+		out.source.reserve(stage.source.length + defineBlock.size());
+		out.source.append(head.data, head.length);
+		out.source += defineBlock;
+		if (!defineBlock.empty())
+			AppendLineDirective(out.source, tailLine, 0);
+
+		std::unordered_set<std::string> included;	// per stage, every stage may want the same header
+		included.insert(filepath);
+		if (!Expand(tail.data, tail.length, filepath, 0, tailLine, out.source, included, shader, 0))
+			return false;
+
+		shader.m_Stages.push_back(std::move(out));
+	}
+	return true;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ShaderParser.h"
+
+// what a file looked like when it was read: two saves within the same second still differ in the nanoseconds (or,
+// on file systems that only keep seconds, most likely in the size)
+struct FileStamp {
+	long long modified;		// nanoseconds
+	long long size;			// bytes
+
+	inline bool operator==(const FileStamp& other) const { return modified == other.modified && size == other.size; }
+	inline bool operator!=(const FileStamp& other) const { return !(*this == other); }
+};
+
+struct ShaderDefine {
+	std::string name;
+	std::string value;		// may be empty
+};
+
+// the output of ShaderPreprocessor::Process - owns the expanded text of every stage
+class PreprocessedShader
+{
+	friend class ShaderPreprocessor;
+
+private:
+	struct Stage {
+		unsigned int type;
+		std::string source;
+		unsigned int firstLine;
+	};
+
+	std::vector<Stage> m_Stages;
+	std::vector<std::string> m_Dependencies;	// the .shader file first, then everything it includes
+
+public:
+	/* views into this object, valid as long as it isn't modified or destroyed */
+	std::vector<ShaderStageSource> GetStages() const;
+	/* #line source string n in a driver error refers to GetDependencies()[n] */
+	inline const std::vector<std::string>& GetDependencies() const { return m_Dependencies; }
+};
+
+// expands a .shader file into its stages, resolving #include "file" (relative to the including file) and injecting
+// #defines after each stage's #version line. Every file read is cached for the life of the preprocessor and only read
+// again when its modification time (to the nanosecond, where the file system has it) or size changes, so building N programs that share headers reads each header once.
+// A file is only included once per stage, repeated includes (and include cycles) are skipped.
+class ShaderPreprocessor
+{
+private:
+	struct CachedFile {
+		FileStamp stamp;
+		std::string contents;
+	};
+
+	std::unordered_map<std::string, CachedFile> m_Files;
+	unsigned int m_Reads;
+	unsigned int m_CacheHits;
+
+	const CachedFile* GetFile(const std::string& filepath);
+	bool Expand(const char* data, size_t length, const std::string& filepath, unsigned int fileIndex, unsigned int firstLine,
+		std::string& out, std::unordered_set<std::string>& included, PreprocessedShader& shader, int depth);
+
+public:
+	ShaderPreprocessor();
+
+	/* returns false (and prints why) if the file or one of its includes couldn't be read */
+	bool Process(const std::string& filepath, const std::vector<ShaderDefine>& defines, PreprocessedShader& shader);
+
+	inline unsigned int GetReadCount() const { return m_Reads; }
+	inline unsigned int GetCacheHitCount() const { return m_CacheHits; }
+};
+
+/* false if the file doesn't exist */
+bool GetFileStamp(const std::string& filepath, FileStamp& stamp);
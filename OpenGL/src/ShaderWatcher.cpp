@@ -0,0 +1,274 @@
+#include "ShaderWatcher.h"
+#include "Shader.h"
+#include "ShaderPreprocessor.h"
+#include <algorithm>
+#include <iostream>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+	// editors often write a file in several steps, wait for it to settle before reloading
+	const std::chrono::milliseconds SettleTime(50);
+#ifndef __linux__
+	const std::chrono::milliseconds PollInterval(250);
+#endif
+
+	std::string GetDirectory(const std::string& filepath)
+	{
+		size_t slash = filepath.find_last_of("/\\");
+		return std::string::npos == slash ? std::string() : filepath.substr(0, slash + 1);
+	}
+}
+
+ShaderWatcher::ShaderWatcher()
+	: m_DependencyEpoch(0), m_Running(true), m_Dirty(false), m_Preprocessed(false)
+{
+#ifdef __linux__
+	m_Wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);		// without it the thread still gets to jobs, just later
+	m_Inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (-1 == m_Inotify) {
+		std::cout << "inotify unavailable, shaders won't be reloaded" << std::endl;
+		return;
+	}
+#endif
+	m_Thread = std::thread(&ShaderWatcher::Run, this);
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+	m_Running = false;
+	Wake();
+	if (m_Thread.joinable())
+		m_Thread.join();
+#ifdef __linux__
+	if (-1 != m_Inotify)
+		close(m_Inotify);
+	if (-1 != m_Wake)
+		close(m_Wake);
+#endif
+}
+
+void ShaderWatcher::Watch(Shader & shader)
+{
+	m_Shaders.push_back({ &shader, shader.GetDependencyVersion() });
+	Register({ shader.GetFilepath() });
+	Register(shader.GetDependencies());
+}
+
+void ShaderWatcher::Unwatch(Shader & shader)
+{
+	m_Shaders.erase(std::remove_if(m_Shaders.begin(), m_Shaders.end(),
+		[&shader](const WatchedShader& watched) { return watched.shader == &shader; }), m_Shaders.end());
+
+	// it may be gone by the time they're done. The thread may be preprocessing some already, it drops those
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Jobs.erase(std::remove_if(m_Jobs.begin(), m_Jobs.end(),
+		[&shader](const ReloadJob& job) { return job.shader == &shader; }), m_Jobs.end());
+	for (auto& job : m_Batch) {
+		if (job.shader == &shader)
+			job.shader = nullptr;
+	}
+	m_Results.erase(std::remove_if(m_Results.begin(), m_Results.end(),
+		[&shader](const ReloadResult& result) { return result.shader == &shader; }), m_Results.end());
+}
+
+void ShaderWatcher::Register(const std::vector<std::string>& files)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (const auto& file : files) {
+		if (!m_Files.insert(file).second)
+			continue;
+
+#ifdef __linux__
+		// watch the directory rather than the file, editors that save by replacing the file would lose a file watch
+		if (-1 == m_Inotify)
+			continue;
+		std::string directory = GetDirectory(file);
+		int wd = inotify_add_watch(m_Inotify, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if (-1 != wd)
+			m_Directories[wd] = directory;
+#endif
+	}
+}
+
+void ShaderWatcher::Run()
+{
+#ifdef __linux__
+	alignas(struct inotify_event) char buffer[4096];
+
+	while (m_Running) {
+		Preprocess();
+
+		pollfd descriptors[] = { { m_Inotify, POLLIN, 0 }, { m_Wake, POLLIN, 0 } };		// poll() skips an fd of -1
+		if (poll(descriptors, 2, 100) <= 0)		// wake up now and then anyway, in case there's no eventfd
+			continue;
+		if (descriptors[1].revents & POLLIN) {
+			uint64_t count;
+			if (read(m_Wake, &count, sizeof(count)) < 0)
+				continue;		// someone else reset it, nothing to do
+		}
+		if (!(descriptors[0].revents & POLLIN))
+			continue;
+
+		ssize_t length = read(m_Inotify, buffer, sizeof(buffer));
+		for (ssize_t offset = 0; offset < length; ) {
+			const inotify_event* event = (const inotify_event*)(buffer + offset);
+			offset += sizeof(inotify_event) + event->len;
+			if (0 == event->len)
+				continue;
+
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			auto directory = m_Directories.find(event->wd);
+			if (directory == m_Directories.end())
+				continue;
+
+			std::string path = directory->second + event->name;
+			if (m_Files.count(path)) {
+				m_Changed.insert(path);
+				m_LastChange = std::chrono::steady_clock::now();
+				m_Dirty = true;
+			}
+		}
+	}
+#else
+	// no change notifications here, compare modification times instead
+	while (m_Running) {
+		Preprocess();
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Wake.wait_for(lock, PollInterval, [this]() { return !m_Jobs.empty() || !m_Running; });
+		}
+
+		std::vector<std::string> files;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			files.assign(m_Files.begin(), m_Files.end());
+		}
+
+		for (const auto& file : files) {
+			FileStamp stamp;
+			if (!GetFileStamp(file, stamp))
+				continue;
+
+			auto it = m_Modified.find(file);
+			if (it == m_Modified.end()) {
+				m_Modified[file] = stamp;	// first sighting
+			}
+			else if (it->second != stamp) {
+				it->second = stamp;
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Changed.insert(file);
+				m_LastChange = std::chrono::steady_clock::now();
+				m_Dirty = true;
+			}
+		}
+	}
+#endif
+}
+
+void ShaderWatcher::Wake()
+{
+#ifdef __linux__
+	if (-1 != m_Wake) {
+		uint64_t one = 1;
+		if (write(m_Wake, &one, sizeof(one)) < 0)
+			return;		// the counter is full, so the thread is being woken anyway
+	}
+#else
+	// under the mutex, so the thread can't miss it between checking for jobs and starting to wait
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Wake.notify_one();
+#endif
+}
+
+void ShaderWatcher::Preprocess()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (m_Jobs.empty())
+			return;
+		m_Batch.swap(m_Jobs);
+	}
+
+	// only this thread resizes m_Batch, Unwatch() just clears a job's shader (under the mutex): the rest of the job can
+	// be read without it
+	for (const auto& job : m_Batch) {
+		PreprocessedShader source;
+		bool processed = m_Preprocessor.Process(job.filepath, job.defines, source);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (!job.shader)
+			continue;		// unwatched meanwhile, it may not exist any more
+		if (!processed) {
+			std::cout << "Reloading " << job.filepath << " failed, keeping the previous version" << std::endl;
+			continue;
+		}
+		m_Results.push_back({ job.shader, job.mask, std::move(source) });
+		m_Preprocessed = true;
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Batch.clear();
+}
+
+void ShaderWatcher::Update()
+{
+	// sources the thread finished preprocessing, off to the compiler
+	if (m_Preprocessed.load(std::memory_order_relaxed)) {
+		std::vector<ReloadResult> results;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			results.swap(m_Results);
+			m_Preprocessed = false;
+		}
+		for (const auto& result : results)
+			result.shader->Reload(result.mask, result.source);
+	}
+
+	// a shader was built and found new includes, watch those too
+	if (Shader::GetDependencyEpoch() != m_DependencyEpoch) {
+		m_DependencyEpoch = Shader::GetDependencyEpoch();
+		for (auto& watched : m_Shaders) {
+			if (watched.dependencyVersion != watched.shader->GetDependencyVersion()) {
+				watched.dependencyVersion = watched.shader->GetDependencyVersion();
+				Register(watched.shader->GetDependencies());
+			}
+		}
+	}
+
+	if (!m_Dirty.load(std::memory_order_relaxed))
+		return;
+
+	std::unordered_set<std::string> changed;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (std::chrono::steady_clock::now() - m_LastChange < SettleTime)
+			return;
+		changed.swap(m_Changed);
+		m_Dirty = false;
+	}
+
+	bool queued = false;
+	for (auto& watched : m_Shaders) {
+		const Shader& shader = *watched.shader;
+		bool affected = changed.count(shader.GetFilepath()) > 0;
+		for (const auto& dependency : shader.GetDependencies())
+			affected = affected || changed.count(dependency) > 0;
+
+		if (!affected)
+			continue;
+
+		// only copies what the thread needs, the files are read there
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (unsigned int mask : shader.GetBuiltMasks())
+			m_Jobs.push_back({ watched.shader, mask, shader.GetFilepath(), shader.GetDefines(mask) });
+		queued = true;
+	}
+	if (queued)
+		Wake();
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ShaderPreprocessor.h"
+
+class Shader;
+
+// watches the files shaders are built from on a background thread (inotify on linux, polling modification times
+// elsewhere) and reloads the shaders that depend on a file that changed. The new sources are read and preprocessed on
+// that thread too (woken as soon as Update() queues them), Update() only hands the finished source to the async
+// compiler and the new program is swapped in by Shader::Update() between frames, so the render loop never waits on the
+// file system or the driver.
+// Update() is an integer compare and two atomic loads on frames where nothing changed.
+class ShaderWatcher
+{
+private:
+	struct WatchedShader {
+		Shader* shader;
+		unsigned int dependencyVersion;		// the version we registered files for
+	};
+
+	// a permutation to preprocess on the thread, and what came of it
+	struct ReloadJob {
+		Shader* shader;
+		unsigned int mask;
+		std::string filepath;
+		std::vector<ShaderDefine> defines;
+	};
+	struct ReloadResult {
+		Shader* shader;
+		unsigned int mask;
+		PreprocessedShader source;
+	};
+
+	std::vector<WatchedShader> m_Shaders;
+	unsigned int m_DependencyEpoch;			// Shader::GetDependencyEpoch() when we last registered files
+	std::thread m_Thread;
+	std::atomic<bool> m_Running;
+	std::atomic<bool> m_Dirty;				// m_Changed isn't empty
+	std::atomic<bool> m_Preprocessed;		// m_Results isn't empty
+	ShaderPreprocessor m_Preprocessor;		// only used by the thread
+
+	std::mutex m_Mutex;						// guards everything below, shared with the thread
+	std::unordered_set<std::string> m_Changed;
+	std::chrono::steady_clock::time_point m_LastChange;
+	std::unordered_set<std::string> m_Files;
+	std::vector<ReloadJob> m_Jobs;
+	std::vector<ReloadJob> m_Batch;			// the jobs the thread is working on, Unwatch() clears their shader
+	std::vector<ReloadResult> m_Results;
+#ifdef __linux__
+	int m_Inotify;
+	int m_Wake;								// eventfd in the thread's poll(), written to wake it
+	std::unordered_map<int, std::string> m_Directories;		// watch descriptor -> directory (with trailing slash)
+#else
+	std::condition_variable m_Wake;			// the thread waits on it between polls
+	std::unordered_map<std::string, FileStamp> m_Modified;
+#endif
+
+	void Register(const std::vector<std::string>& files);
+	void Run();
+	/* gets the thread out of its wait, to preprocess jobs or to stop */
+	void Wake();
+	/* on the thread: preprocesses what Update() queued */
+	void Preprocess();
+
+public:
+	ShaderWatcher();
+	~ShaderWatcher();
+
+	/* the shader must outlive the watcher (or be unwatched) */
+	void Watch(Shader& shader);
+	void Unwatch(Shader& shader);
+
+	/* call once a frame, before Shader::Update() */
+	void Update();
+};
@@ -0,0 +1,93 @@
+#include "StreamingVertexBuffer.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+#include "GLBuffer.h"
+
+StreamingVertexBuffer::StreamingVertexBuffer(unsigned int regionSize, unsigned int regions, bool persistent)
+	: m_RegionSize(regionSize), m_Regions(regions), m_Region(0), m_Persistent(persistent && (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)),
+	m_Mapped(nullptr), m_Fences(regions, nullptr)
+{
+	ASSERT(regions > 0);
+	m_Stats.maps = 0;
+	m_Stats.stalls = 0;
+
+	if (m_Persistent) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		m_RendererID = GLBuffer::CreateStorage(regionSize * regions, nullptr, flags);
+		m_Mapped = (unsigned char*)GLBuffer::Map(m_RendererID, 0, regionSize * regions, flags);
+		ASSERT(m_Mapped);
+	}
+	else {
+		m_Staging.resize(regionSize);
+		m_RendererID = GLBuffer::Create(regionSize, nullptr, GL_STREAM_DRAW);
+	}
+}
+
+StreamingVertexBuffer::~StreamingVertexBuffer()
+{
+	for (void* fence : m_Fences) {
+		if (fence) {
+			GLCall(glDeleteSync((GLsync)fence));
+		}
+	}
+
+	if (m_Mapped)
+		GLBuffer::Unmap(m_RendererID);
+	GLStateCache::Get().DeleteBuffer(m_RendererID);
+}
+
+void StreamingVertexBuffer::Bind() const
+{
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, m_RendererID);
+}
+
+void StreamingVertexBuffer::Unbind() const
+{
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void * StreamingVertexBuffer::Map()
+{
+	m_Stats.maps++;
+	if (!m_Persistent)
+		return m_Staging.data();
+
+	// the GPU may still be reading the last thing written here, a coherent mapping doesn't protect us from that
+	if (GLsync fence = (GLsync)m_Fences[m_Region]) {
+		GLenum result;
+		GLCall(result = glClientWaitSync(fence, 0, 0));
+		if (result == GL_TIMEOUT_EXPIRED) {
+			m_Stats.stalls++;
+			do {
+				GLCall(result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000));	// 1s
+			} while (result == GL_TIMEOUT_EXPIRED);
+		}
+		GLCall(glDeleteSync(fence));
+		m_Fences[m_Region] = nullptr;
+	}
+	return m_Mapped + (size_t)m_Region * m_RegionSize;
+}
+
+void StreamingVertexBuffer::Unmap(unsigned int size)
+{
+	ASSERT(size <= m_RegionSize);
+	if (m_Persistent)
+		return;		// coherent, the writes are visible to the next command as they are
+
+	GLBuffer::SetData(m_RendererID, m_RegionSize, nullptr, GL_STREAM_DRAW);	// orphan
+	GLBuffer::SetSubData(m_RendererID, 0, size, m_Staging.data());
+}
+
+unsigned int StreamingVertexBuffer::GetOffset() const
+{
+	return m_Persistent ? m_Region * m_RegionSize : 0;
+}
+
+void StreamingVertexBuffer::Fence()
+{
+	if (!m_Persistent)
+		return;		// the driver tracks the orphaned storage for us
+
+	GLCall(m_Fences[m_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	m_Region = (m_Region + 1) % m_Regions;
+}
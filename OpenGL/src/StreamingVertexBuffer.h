@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+
+// a vertex buffer rewritten every frame without stalling. With ARB_buffer_storage (GL 4.4) it's created with
+// glBufferStorage and mapped once, persistent and coherent, and split into regions used round robin: Map() hands out
+// the next region's memory to write the vertices straight into, Fence() after the draws that read it puts a fence
+// behind them, and a region is only handed out again once its fence has passed (Map() waits for it otherwise - that's
+// a stall, counted). Without buffer storage, or if asked not to use it, it falls back to orphaning: Map() returns a
+// staging copy and Unmap() reallocates the buffer (glBufferData NULL) and uploads with glBufferSubData.
+//   Map() -> write -> Unmap(size) -> draw from GetOffset() -> Fence()
+class StreamingVertexBuffer
+{
+public:
+	struct Stats {
+		unsigned int maps;
+		unsigned int stalls;		// maps that had to wait for the GPU to finish with the region
+	};
+
+private:
+	unsigned int m_RendererID;		// opengl id
+	unsigned int m_RegionSize;		// bytes
+	unsigned int m_Regions;
+	unsigned int m_Region;			// the one being written / drawn
+	bool m_Persistent;
+	unsigned char* m_Mapped;		// the whole buffer when persistent
+	std::vector<void*> m_Fences;	// GLsync per region, nullptr when the region is free
+	std::vector<unsigned char> m_Staging;	// what Map() returns when orphaning
+	Stats m_Stats;
+
+public:
+	/* regionSize: the most that's written between two Fence() calls, best a multiple of the vertex size.
+	   persistent: use persistent mapping when the context has it, false forces orphaning */
+	StreamingVertexBuffer(unsigned int regionSize, unsigned int regions = 3, bool persistent = true);
+	~StreamingVertexBuffer();
+	void Bind() const;
+	void Unbind() const;
+
+	/* memory for up to GetRegionSize() bytes, write only (it may be uncached) */
+	void* Map();
+	/* size: bytes written */
+	void Unmap(unsigned int size);
+	/* where what was just written starts in the buffer, divide by the stride for a base vertex */
+	unsigned int GetOffset() const;
+	/* after the draws reading this region, moves on to the next one */
+	void Fence();
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline bool IsPersistent() const { return m_Persistent; }
+	inline unsigned int GetRegionSize() const { return m_RegionSize; }
+	inline const Stats& GetStats() const { return m_Stats; }
+	inline void ResetStats() { m_Stats.maps = 0; m_Stats.stalls = 0; }
+};
@@ -0,0 +1,112 @@
+#include "UniformBuffer.h"
+#include "Renderer.h"
+#include "GLBuffer.h"
+#include "GLStateCache.h"
+#include <iostream>
+
+// the std140 rules, checked against the examples in the GL spec
+typedef Std140Layout<std140::Float, std140::Vec3, std140::Mat4, std140::Vec2, std140::Array<std140::Float, 2>, std140::Mat3> Std140Check;
+static_assert(Std140Check::Offset<1>::value == 16, "vec3 aligns to 16");
+static_assert(Std140Check::Offset<2>::value == 32, "mat4 follows the vec3's 12 bytes, aligned to 16");
+static_assert(Std140Check::Offset<3>::value == 96, "vec2 after a mat4");
+static_assert(Std140Check::Offset<4>::value == 112, "arrays align to 16");
+static_assert(Std140Check::Offset<5>::value == 144, "float[2] has a 16 byte stride");
+static_assert(Std140Check::Size == 192, "mat3 is three padded columns");
+
+unsigned int UniformBuffer::QueryAlignment()
+{
+	int alignment = 256;
+	GLCall(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+	return (unsigned int)alignment;
+}
+
+UniformBuffer::UniformBuffer(unsigned int frameSize, bool persistent)
+	: m_Frame(0), m_Head(0), m_Persistent(persistent && (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)), m_Mapped(nullptr)
+{
+	m_Alignment = QueryAlignment();
+	m_Stats.uploads = 0;
+	m_Stats.stalls = 0;
+
+	// every region starts aligned, so offsets within it only need aligning relative to the region
+	m_RegionSize = std140::AlignUp(frameSize, m_Alignment);
+	for (auto& fence : m_Fences)
+		fence = nullptr;
+
+	if (m_Persistent) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		m_RendererID = GLBuffer::CreateStorage(m_RegionSize * FramesInFlight, nullptr, flags);
+		m_Mapped = (unsigned char*)GLBuffer::Map(m_RendererID, 0, m_RegionSize * FramesInFlight, flags);
+		ASSERT(m_Mapped);
+	}
+	else {
+		m_Staging.resize(m_RegionSize);
+		m_RendererID = GLBuffer::CreateImmutable(m_RegionSize * FramesInFlight, nullptr, GL_DYNAMIC_DRAW);
+	}
+}
+
+UniformBuffer::~UniformBuffer()
+{
+	for (auto fence : m_Fences) {
+		if (fence) {
+			GLCall(glDeleteSync((GLsync)fence));
+		}
+	}
+	if (m_Mapped)
+		GLBuffer::Unmap(m_RendererID);
+	GLStateCache::Get().DeleteBuffer(m_RendererID);
+}
+
+void UniformBuffer::BeginFrame()
+{
+	m_Head = 0;
+
+	// the region was last used FramesInFlight frames ago, so this is normally already signalled
+	if (GLsync fence = (GLsync)m_Fences[m_Frame]) {
+		GLenum result;
+		GLCall(result = glClientWaitSync(fence, 0, 0));
+		if (GL_TIMEOUT_EXPIRED == result) {
+			m_Stats.stalls++;
+			do {
+				GLCall(result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000));	// 1ms
+			} while (GL_TIMEOUT_EXPIRED == result);
+		}
+		GLCall(glDeleteSync(fence));
+		m_Fences[m_Frame] = nullptr;
+	}
+}
+
+UniformBuffer::Allocation UniformBuffer::Allocate(unsigned int size)
+{
+	unsigned int offset = std140::AlignUp(m_Head, m_Alignment);
+	if (offset + size > m_RegionSize) {
+		std::cout << "Uniform buffer full: " << m_RegionSize << " bytes per frame" << std::endl;
+		return { 0, 0, nullptr };
+	}
+
+	m_Head = offset + size;
+	const unsigned int region = m_Frame * m_RegionSize;
+	return { region + offset, size, m_Persistent ? m_Mapped + region + offset : &m_Staging[offset] };
+}
+
+void UniformBuffer::Upload()
+{
+	if (0 == m_Head || m_Persistent)
+		return;		// coherent, the blocks were written straight into the buffer
+
+	// one upload for every block allocated this frame
+	GLBuffer::SetSubData(m_RendererID, m_Frame * m_RegionSize, m_Head, m_Staging.data());
+	m_Stats.uploads++;
+}
+
+void UniformBuffer::EndFrame()
+{
+	if (m_Persistent) {
+		GLCall(m_Fences[m_Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	}
+	m_Frame = (m_Frame + 1) % FramesInFlight;
+}
+
+void UniformBuffer::Bind(unsigned int bindingPoint, const Allocation & allocation) const
+{
+	GLCall(glBindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, m_RendererID, allocation.offset, allocation.size));
+}
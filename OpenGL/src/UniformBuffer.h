@@ -0,0 +1,167 @@
+#pragma once
+#include <cstring>
+#include <tuple>
+#include <vector>
+
+// std140 layout rules, evaluated at compile time. A uniform block is described by the list of its member types:
+//   typedef Std140Layout<std140::Mat4, std140::Vec4, std140::Float> ObjectBlock;	// mat4 model; vec4 colour; float time;
+//   ObjectBlock::Offset<1>::value == 64, ObjectBlock::Size == 96
+//   ObjectBlock::Write<1>(dst, colour);
+namespace std140 {
+
+	constexpr unsigned int AlignUp(unsigned int value, unsigned int alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// a scalar or vector, stored as-is
+	template<typename T, unsigned int Components, unsigned int Align>
+	struct Basic {
+		typedef T Type;
+		static constexpr unsigned int Alignment = Align;
+		static constexpr unsigned int Size = Components * sizeof(T);
+
+		static void Store(unsigned char* dst, const T* src) { memcpy(dst, src, Size); }
+	};
+
+	typedef Basic<float, 1, 4> Float;
+	typedef Basic<float, 2, 8> Vec2;
+	typedef Basic<float, 3, 16> Vec3;
+	typedef Basic<float, 4, 16> Vec4;
+	typedef Basic<int, 1, 4> Int;
+	typedef Basic<int, 2, 8> IVec2;
+	typedef Basic<int, 4, 16> IVec4;
+	typedef Basic<unsigned int, 1, 4> UInt;
+
+	// arrays (and matrix columns) have every element padded out to a vec4
+	template<typename Element, unsigned int Count>
+	struct Array {
+		typedef typename Element::Type Type;
+		static constexpr unsigned int Stride = AlignUp(Element::Size, 16);
+		static constexpr unsigned int Alignment = 16;
+		static constexpr unsigned int Size = Stride * Count;
+
+		/* src is tightly packed */
+		static void Store(unsigned char* dst, const Type* src)
+		{
+			for (unsigned int i = 0; i < Count; i++)
+				Element::Store(dst + i * Stride, src + i * (Element::Size / sizeof(Type)));
+		}
+	};
+
+	// column major, so a matN is an array of N vecN columns
+	typedef Array<Vec3, 3> Mat3;
+	typedef Array<Vec4, 4> Mat4;
+}
+
+// offset of member Index when the members start at Base
+template<unsigned int Index, unsigned int Base, typename... Members>
+struct Std140Offset;
+
+template<unsigned int Base, typename First, typename... Rest>
+struct Std140Offset<0, Base, First, Rest...> {
+	static constexpr unsigned int value = std140::AlignUp(Base, First::Alignment);
+};
+
+template<unsigned int Index, unsigned int Base, typename First, typename... Rest>
+struct Std140Offset<Index, Base, First, Rest...> {
+	static constexpr unsigned int value = Std140Offset<Index - 1, std140::AlignUp(Base, First::Alignment) + First::Size, Rest...>::value;
+};
+
+// end of the last member
+template<unsigned int Base, typename... Members>
+struct Std140End {
+	static constexpr unsigned int value = Base;
+};
+
+template<unsigned int Base, typename First, typename... Rest>
+struct Std140End<Base, First, Rest...> {
+	static constexpr unsigned int value = Std140End<std140::AlignUp(Base, First::Alignment) + First::Size, Rest...>::value;
+};
+
+template<typename... Members>
+struct Std140Layout {
+	template<unsigned int Index>
+	struct Member {
+		typedef typename std::tuple_element<Index, std::tuple<Members...>>::type Type;
+	};
+
+	template<unsigned int Index>
+	struct Offset {
+		static_assert(Index < sizeof...(Members), "std140 member index out of range");
+		static constexpr unsigned int value = Std140Offset<Index, 0, Members...>::value;
+	};
+
+	/* the block's size rounded up to a vec4, as a block in an array (or a buffer range) would be */
+	static constexpr unsigned int Size = std140::AlignUp(Std140End<0, Members...>::value, 16);
+
+	/* copies member Index into a block starting at dst, src is tightly packed */
+	template<unsigned int Index>
+	static void Write(void* dst, const typename Member<Index>::Type::Type* src)
+	{
+		Member<Index>::Type::Store((unsigned char*)dst + Offset<Index>::value, src);
+	}
+};
+
+// uniform data for a frame is packed into std140 blocks sub-allocated from one buffer and bound per draw with
+// glBindBufferRange. The buffer is split into FramesInFlight regions used round robin. With ARB_buffer_storage (GL 4.4)
+// it's mapped once, persistent and coherent: Allocate() hands out memory in the mapped region, so there's no upload at
+// all, and each region is fenced so it's only written again once the GPU is done reading it (BeginFrame() waits
+// otherwise - a stall, counted). Without it blocks are packed into a CPU staging area and go up with one
+// glBufferSubData, which the driver synchronises itself.
+//   BeginFrame() -> Allocate()/write for every draw -> Upload() -> Bind() per draw -> EndFrame()
+class UniformBuffer
+{
+public:
+	struct Allocation {
+		unsigned int offset;	// in the buffer, already aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+		unsigned int size;
+		void* data;				// where to write it, valid until Upload() (write only, it may be uncached memory)
+	};
+
+	struct Stats {
+		unsigned int uploads;	// glBufferSubData calls, none when persistent
+		unsigned int stalls;	// BeginFrame() calls that had to wait for the GPU
+	};
+
+private:
+	static const unsigned int FramesInFlight = 3;
+
+	unsigned int m_RendererID;		// opengl id
+	unsigned int m_RegionSize;		// bytes per frame
+	unsigned int m_Alignment;		// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	unsigned int m_Frame;			// region in use, 0..FramesInFlight-1
+	unsigned int m_Head;			// bytes allocated this frame
+	bool m_Persistent;
+	unsigned char* m_Mapped;		// the whole buffer when persistent
+	std::vector<unsigned char> m_Staging;	// this frame's blocks otherwise
+	void* m_Fences[FramesInFlight];	// GLsync, set when a region's frame was submitted (persistent only)
+	Stats m_Stats;
+
+public:
+	/* GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, every allocation starts at a multiple of it: size frames with it, a frame of n
+	   blocks takes n * AlignUp(block size, QueryAlignment()) */
+	static unsigned int QueryAlignment();
+
+	/* frameSize: bytes of uniform data a single frame may allocate. persistent: false forces the glBufferSubData path */
+	UniformBuffer(unsigned int frameSize, bool persistent = true);
+	~UniformBuffer();
+
+	/* waits (normally not at all) until the GPU is done with the region this frame reuses */
+	void BeginFrame();
+	/* data is nullptr if the frame's region is full */
+	Allocation Allocate(unsigned int size);
+	template<typename Layout>
+	inline Allocation Allocate() { return Allocate(Layout::Size); }
+	/* makes everything allocated this frame visible to the GPU, must come before the draws that use it */
+	void Upload();
+	void EndFrame();
+
+	void Bind(unsigned int bindingPoint, const Allocation& allocation) const;
+
+	inline unsigned int GetAlignment() const { return m_Alignment; }
+	inline unsigned int GetUsed() const { return m_Head; }
+	inline bool IsPersistent() const { return m_Persistent; }
+	inline const Stats& GetStats() const { return m_Stats; }
+	inline void ResetStats() { m_Stats.uploads = 0; m_Stats.stalls = 0; }
+};
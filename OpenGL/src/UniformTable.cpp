@@ -0,0 +1,97 @@
+#include "UniformTable.h"
+#include "Renderer.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+UniformStats UniformTable::s_FrameStats = { 0, 0 };
+
+UniformTable::UniformTable(unsigned int program)
+	: m_Program(program)
+{
+	int count = 0, maxLength = 0;
+	GLCall(glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count));
+	GLCall(glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength));
+
+	std::vector<char> name(maxLength + 1);
+	m_Uniforms.reserve(count);
+
+	for (int i = 0; i < count; i++) {
+		int length, size;
+		GLenum type;
+		GLCall(glGetActiveUniform(program, i, maxLength, &length, &size, &type, name.data()));
+
+		GLCall(int location = glGetUniformLocation(program, name.data()));
+		if (-1 == location)
+			continue;	// a member of a uniform block, those are set through buffers
+
+		// arrays are reported as "name[0]", we look them up by "name"
+		if (length > 3 && 0 == strcmp(name.data() + length - 3, "[0]"))
+			name[length - 3] = '\0';
+
+		Uniform uniform;
+		uniform.hash = HashUniformName(name.data());
+		uniform.location = location;
+		uniform.type = type;
+		uniform.size = size;
+		uniform.shadowed = false;
+		m_Uniforms.push_back(uniform);
+	}
+
+	std::sort(m_Uniforms.begin(), m_Uniforms.end(), [](const Uniform& a, const Uniform& b) { return a.hash < b.hash; });
+	for (size_t i = 1; i < m_Uniforms.size(); i++) {
+		if (m_Uniforms[i].hash == m_Uniforms[i - 1].hash)
+			std::cout << "Warning: two uniforms in program " << program << " have the same name hash, rename one" << std::endl;
+	}
+}
+
+UniformTable::Uniform * UniformTable::Find(const UniformName & name)
+{
+	auto it = std::lower_bound(m_Uniforms.begin(), m_Uniforms.end(), name.hash, [](const Uniform& a, unsigned int hash) { return a.hash < hash; });
+	if (it != m_Uniforms.end() && it->hash == name.hash)
+		return &*it;
+
+	// remember the miss so we only warn once
+	std::cout << "Warning: uniform '" << name.name << "' doesn't exist in program " << m_Program << std::endl;
+	Uniform missing;
+	missing.hash = name.hash;
+	missing.location = -1;
+	missing.type = 0;
+	missing.size = 0;
+	missing.shadowed = false;
+	return &*m_Uniforms.insert(it, missing);
+}
+
+int UniformTable::GetLocation(const UniformName & name)
+{
+	return Find(name)->location;
+}
+
+int UniformTable::Set(const UniformName & name, const void * value, unsigned int bytes)
+{
+	Uniform* uniform = Find(name);
+	if (-1 == uniform->location)
+		return -1;
+
+	if (bytes > sizeof(uniform->value)) {
+		// arrays aren't shadowed
+		s_FrameStats.uploads++;
+		return uniform->location;
+	}
+
+	if (uniform->shadowed && 0 == memcmp(uniform->value, value, bytes)) {
+		s_FrameStats.elided++;
+		return -1;
+	}
+
+	memcpy(uniform->value, value, bytes);
+	uniform->shadowed = true;
+	s_FrameStats.uploads++;
+	return uniform->location;
+}
+
+void UniformTable::ResetFrameStats()
+{
+	s_FrameStats.uploads = 0;
+	s_FrameStats.elided = 0;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+
+// 32 bit FNV-1a, usable at compile time
+constexpr unsigned int HashUniformName(const char* name, unsigned int hash = 2166136261u)
+{
+	return *name ? HashUniformName(name + 1, (hash ^ (unsigned char)*name) * 16777619u) : hash;
+}
+
+// a uniform name reduced to its hash. Converts implicitly from a string, declare it constexpr to hash at compile time:
+//   static constexpr UniformName u_Colour("u_Colour");
+struct UniformName {
+	unsigned int hash;
+	const char* name;	// only used for error messages
+
+	constexpr UniformName(const char* name)
+		: hash(HashUniformName(name)), name(name) {
+	}
+};
+
+struct UniformStats {
+	unsigned int uploads;		// glUniform* calls issued
+	unsigned int elided;		// calls skipped because the value hadn't changed
+};
+
+// every active uniform of a linked program, reflected once after linking. Uploads go through Set(), which skips the
+// GL call when the value is the same as the last one uploaded (uniform values are program state, so the shadow stays
+// valid while other programs are bound)
+class UniformTable
+{
+private:
+	struct Uniform {
+		unsigned int hash;
+		int location;			// -1 for names the program doesn't have, cached so we only look them up once
+		unsigned int type;		// GL_FLOAT_VEC4...
+		int size;				// array length
+		bool shadowed;			// false until the first upload
+		unsigned char value[64];	// last uploaded value, big enough for a mat4
+	};
+
+	std::vector<Uniform> m_Uniforms;	// sorted by hash
+	unsigned int m_Program;
+
+	static UniformStats s_FrameStats;
+
+	Uniform* Find(const UniformName& name);
+
+public:
+	/* program must be linked */
+	UniformTable(unsigned int program);
+
+	/* location of the uniform, -1 if the program doesn't have it */
+	int GetLocation(const UniformName& name);
+
+	/* returns the location to upload to, or -1 if the upload can be skipped (unchanged value or unknown name).
+	   the new value is recorded as the shadow, so the caller must upload it */
+	int Set(const UniformName& name, const void* value, unsigned int bytes);
+
+	inline unsigned int GetProgram() const { return m_Program; }
+	inline unsigned int GetCount() const { return (unsigned int)m_Uniforms.size(); }
+
+	/* uploads and elided uploads across all programs since the last reset, reset once a frame */
+	static inline const UniformStats& GetFrameStats() { return s_FrameStats; }
+	static void ResetFrameStats();
+};
@@ -1,43 +1,177 @@
 #include "VertexArray.h"
+#include "IndexBuffer.h"
 #include "Renderer.h"
+#include "GLStateCache.h"
+#include "GLBuffer.h"
 
 VertexArray::VertexArray()
+	: m_SeparateFormat(GLEW_VERSION_4_3 || GLEW_ARB_vertex_attrib_binding),
+	m_DirectStateAccess(m_SeparateFormat && GLBuffer::HasDirectStateAccess())
 {
-	GLCall(glGenVertexArrays(1, &m_RendererID));
+	if (m_DirectStateAccess) {
+		GLCall(glCreateVertexArrays(1, &m_RendererID));		// a complete object already, no bind needed to create it
+	}
+	else {
+		GLCall(glGenVertexArrays(1, &m_RendererID));
+	}
 	//GLCall(glBindVertexArray(m_RendererID));
 }
 
 VertexArray::~VertexArray()
 {
-	GLCall(glDeleteVertexArrays(1, &m_RendererID));
+	GLStateCache::Get().DeleteVertexArray(m_RendererID);
 }
 
-void VertexArray::AddBuffer(const VertexBuffer & vb, VertexBufferLayout & layout)
+unsigned int VertexArray::AddFormat(const VertexBufferLayout & layout)
 {
-	Bind();
-	vb.Bind();
 	const auto &elements = layout.GetElements();
+
+	std::vector<VertexAttribute> attributes;
 	unsigned int offset = 0;
+	for (const auto& element : elements) {
+		attributes.push_back({ element.type, element.count, element.normalised, element.integer, offset });
+		offset += VertexBufferElement::GetSize(element.type, element.count);
+	}
+	return AddFormat(attributes.data(), (unsigned int)attributes.size(), layout.GetStride(), layout.GetDivisor());
+}
+
+unsigned int VertexArray::AddFormat(const VertexAttribute * attributes, unsigned int count, unsigned int stride, unsigned int divisor)
+{
+	const unsigned int binding = (unsigned int)m_Bindings.size();
+	const unsigned int first = (unsigned int)m_Attributes.size();
+	m_Bindings.push_back({ stride, divisor, first, count });
+	m_Attributes.insert(m_Attributes.end(), attributes, attributes + count);
+
+	if (m_DirectStateAccess) {
+		for (unsigned int i = 0; i < count; i++) {
+			const VertexAttribute& attribute = attributes[i];
+			const unsigned int location = first + i;
+			ASSERT(attribute.offset <= 2047);
+			GLCall(glEnableVertexArrayAttrib(m_RendererID, location));
+			if (attribute.integer) {
+				GLCall(glVertexArrayAttribIFormat(m_RendererID, location, attribute.count, attribute.type, attribute.offset));
+			}
+			else {
+				GLCall(glVertexArrayAttribFormat(m_RendererID, location, attribute.count, attribute.type, attribute.normalised, attribute.offset));
+			}
+			GLCall(glVertexArrayAttribBinding(m_RendererID, location, binding));
+		}
+		if (divisor) {
+			GLCall(glVertexArrayBindingDivisor(m_RendererID, binding, divisor));
+		}
+		return binding;
+	}
+
+	Bind();
+	for (unsigned int i = 0; i < count; i++) {
+		const VertexAttribute& attribute = attributes[i];
+		const unsigned int location = first + i;
+		GLCall(glEnableVertexAttribArray(location));
+		if (!m_SeparateFormat) {
+			// the format goes with the buffer, SetVertexBuffer sets both
+			if (divisor) {
+				GLCall(glVertexAttribDivisor(location, divisor));	// per instance
+			}
+			continue;
+		}
+
+		// offsets are relative to the vertex now, the buffer's own offset comes with glBindVertexBuffer
+		ASSERT(attribute.offset <= 2047);	// the smallest GL_MAX_VERTEX_ATTRIB_RELATIVE_OFFSET allowed
+		if (attribute.integer) {
+			GLCall(glVertexAttribIFormat(location, attribute.count, attribute.type, attribute.offset));	// stays an int
+		}
+		else {
+			GLCall(glVertexAttribFormat(location, attribute.count, attribute.type, attribute.normalised, attribute.offset));
+		}
+		GLCall(glVertexAttribBinding(location, binding));
+	}
+	if (m_SeparateFormat && divisor) {
+		GLCall(glVertexBindingDivisor(binding, divisor));		// per instance
+	}
+	return binding;
+}
+
+void VertexArray::SetVertexBuffer(unsigned int binding, const VertexBuffer & vb, unsigned int offset)
+{
+	SetVertexBuffer(binding, vb.GetRendererID(), vb.GetOffset() + offset);
+}
+
+void VertexArray::SetVertexBuffer(unsigned int binding, const StreamingVertexBuffer & vb, unsigned int offset)
+{
+	SetVertexBuffer(binding, vb.GetRendererID(), offset);
+}
+
+void VertexArray::SetVertexBuffer(unsigned int binding, unsigned int buffer, unsigned int offset)
+{
+	ASSERT(binding < m_Bindings.size());
+	const Binding& format = m_Bindings[binding];
+
+	if (m_DirectStateAccess) {
+		GLCall(glVertexArrayVertexBuffer(m_RendererID, binding, buffer, offset, format.stride));
+		return;
+	}
+	Bind();
+	if (m_SeparateFormat) {
+		GLCall(glBindVertexBuffer(binding, buffer, offset, format.stride));
+		return;
+	}
+
+	// specify layout of the vertex buffer (so opengl knows how to interpret the data): glVertexAttribPointer takes
+	// whatever is bound to GL_ARRAY_BUFFER, with the offset passed as a pointer
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, buffer);
+	for (unsigned int location = format.firstAttribute; location < format.firstAttribute + format.attributeCount; location++) {
+		const VertexAttribute& attribute = m_Attributes[location];
+		const void* pointer = (const void*)(size_t)(offset + attribute.offset);
+		if (attribute.integer) {
+			GLCall(glVertexAttribIPointer(location, attribute.count, attribute.type, format.stride, pointer));
+		}
+		else {
+			GLCall(glVertexAttribPointer(location, attribute.count, attribute.type, attribute.normalised, format.stride, pointer));
+		}
+	}
+}
 
-	for(unsigned int i = 0; i < elements.size(); i++)
-	{
-		const auto& element = elements[i];
-		// specify layout of the vertex buffer (so opengl knows how to interpret the data):
-		// enable index 0 of the vertex arrays (we only have one array) 
-		GLCall(glEnableVertexAttribArray(i));
-		// "bind index 0 of the vertex array (which in our sample code only has 1 array) to the currently bound vertex buffer" (...with this layout?)
-		GLCall(glVertexAttribPointer(i, element.count, element.type, element.normalised, layout.GetStride(), (const void*) offset));
-		offset += element.count * VertexBufferElement::GetSizeOfType(element.type);
+void VertexArray::SetVertexBuffers(unsigned int first, unsigned int count, const VertexBuffer * const * buffers)
+{
+	ASSERT(first + count <= m_Bindings.size());
+	if (!m_SeparateFormat || !(GLEW_VERSION_4_4 || GLEW_ARB_multi_bind)) {
+		for (unsigned int i = 0; i < count; i++)
+			SetVertexBuffer(first + i, *buffers[i]);
+		return;
+	}
+
+	std::vector<GLuint> names(count);
+	std::vector<GLintptr> offsets(count);
+	std::vector<GLsizei> strides(count);
+	for (unsigned int i = 0; i < count; i++) {
+		names[i] = buffers[i]->GetRendererID();
+		offsets[i] = buffers[i]->GetOffset();
+		strides[i] = m_Bindings[first + i].stride;
+	}
+	if (m_DirectStateAccess) {
+		GLCall(glVertexArrayVertexBuffers(m_RendererID, first, count, names.data(), offsets.data(), strides.data()));
+		return;
 	}
+	Bind();
+	GLCall(glBindVertexBuffers(first, count, names.data(), offsets.data(), strides.data()));
+}
 
+void VertexArray::SetIndexBuffer(const IndexBuffer & ib)
+{
+	if (m_DirectStateAccess) {
+		GLStateCache::Get().SetElementBuffer(m_RendererID, ib.GetRendererID());
+		return;
+	}
+	Bind();
+	ib.Bind();
 }
 
 void VertexArray::Bind() const
 {
-	GLCall(glBindVertexArray(m_RendererID));
+	GLStateCache::Get().BindVertexArray(m_RendererID);
 }
 
 void VertexArray::Unbind() const
 {
-	GLCall(glBindVertexArray(0));
+	GLStateCache::Get().BindVertexArray(0);
 }
@@ -1,20 +1,78 @@
 #pragma once
+#include <vector>
 #include "VertexBuffer.h"
+#include "StreamingVertexBuffer.h"
 #include "VertexBufferLayout.h"
 
-// ties together a vertex buffer (just bytes ) with it's layout
+class IndexBuffer;
+
+// ties together vertex buffers (just bytes) with their layouts. Each layout added is a binding: its format is described
+// once and any buffer holding vertices of that format can be swapped in with SetVertexBuffer, so one vertex array can
+// serve every mesh of a format. With ARB_vertex_attrib_binding (GL 4.3) that's glVertexAttribFormat once and a
+// glBindVertexBuffer per swap; without it the swap sets the binding's attribute pointers again. With direct state access
+// (GL 4.5) none of it binds the vertex array, only drawing does.
+//   binding = AddFormat(layout) -> SetVertexBuffer(binding, vb) -> draw -> SetVertexBuffer(binding, other) -> draw
 class VertexArray
 {
 private:
+	struct Binding {
+		unsigned int stride;
+		unsigned int divisor;
+		unsigned int firstAttribute;	// in m_Attributes, which is also the first location
+		unsigned int attributeCount;
+	};
+
 	unsigned int m_RendererID;		// opengl id
+	bool m_SeparateFormat;			// ARB_vertex_attrib_binding
+	bool m_DirectStateAccess;		// glVertexArray*, implies m_SeparateFormat
+	std::vector<Binding> m_Bindings;
+	std::vector<VertexAttribute> m_Attributes;	// attribute i is at location i
+
+	/* the next binding, its attributes take the next free locations */
+	unsigned int AddFormat(const VertexAttribute* attributes, unsigned int count, unsigned int stride, unsigned int divisor);
+	/* offset is in bytes */
+	void SetVertexBuffer(unsigned int binding, unsigned int buffer, unsigned int offset);
 
 public:
 	VertexArray();
 	~VertexArray();
 
-	void AddBuffer(const VertexBuffer& vb, VertexBufferLayout& layout);
+	/* adds a binding with this format and no buffer yet (set one before drawing), returns its index */
+	unsigned int AddFormat(const VertexBufferLayout& layout);
+	/* the same with a compile time layout (MakeVertexLayout) */
+	template<size_t N>
+	unsigned int AddFormat(const VertexLayout<N>& layout)
+	{
+		return AddFormat(layout.attributes.data(), N, layout.stride, layout.divisor);
+	}
+
+	/* binding reads vb from offset bytes in (plus a view's offset into its arena, which is baked in: set it again if
+	   the arena is defragmented) */
+	void SetVertexBuffer(unsigned int binding, const VertexBuffer& vb, unsigned int offset = 0);
+	/* read from the start of the buffer, draw with a base vertex for the current region (or set it with GetOffset()) */
+	void SetVertexBuffer(unsigned int binding, const StreamingVertexBuffer& vb, unsigned int offset = 0);
+	/* count bindings from first in one call, glBindVertexBuffers with GL 4.4 or ARB_multi_bind */
+	void SetVertexBuffers(unsigned int first, unsigned int count, const VertexBuffer* const* buffers);
+	/* the element buffer is part of the vertex array too */
+	void SetIndexBuffer(const IndexBuffer& ib);
+
+	/* AddFormat and SetVertexBuffer in one. Bindings (and their locations) follow each other, so a second buffer
+	   (e.g. per instance data) comes after the first one's */
+	template<typename Layout>
+	void AddBuffer(const VertexBuffer& vb, const Layout& layout)
+	{
+		SetVertexBuffer(AddFormat(layout), vb);
+	}
+	template<typename Layout>
+	void AddBuffer(const StreamingVertexBuffer& vb, const Layout& layout)
+	{
+		SetVertexBuffer(AddFormat(layout), vb);
+	}
+
+	inline unsigned int GetBindingCount() const { return (unsigned int)m_Bindings.size(); }
+	inline bool HasSeparateFormat() const { return m_SeparateFormat; }
 
 	void Bind() const;
 	void Unbind() const;
 
-};
\ No newline at end of file
+};
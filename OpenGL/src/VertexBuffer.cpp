@@ -1,24 +1,73 @@
 #include "VertexBuffer.h"
 #include "Renderer.h"
+#include "GLStateCache.h"
+#include "BufferArena.h"
+#include "GLBuffer.h"
 
 VertexBuffer::VertexBuffer(const void * data, unsigned int size)
+	: m_Size(size), m_Arena(nullptr), m_Allocation(BufferArena::Invalid)
+{
+ 	m_RendererID = GLBuffer::CreateImmutable(size, data, GL_STATIC_DRAW);	// get a buffer id and assign data to it, nothing is bound
+}
+
+VertexBuffer::VertexBuffer(unsigned int size)
+	: m_Size(size), m_Arena(nullptr), m_Allocation(BufferArena::Invalid)
+{
+	m_RendererID = GLBuffer::Create(size, nullptr, GL_DYNAMIC_DRAW);		// not immutable, SetData orphans it
+}
+
+VertexBuffer::VertexBuffer(BufferArena & arena, const void * data, unsigned int size)
+	: m_RendererID(0), m_Size(size), m_Arena(&arena), m_Allocation(arena.Allocate(size, 4, data))
 {
- 	GLCall(glGenBuffers(1, &m_RendererID));	// get a buffer id
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));		// select the buffer
-	GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));	// assign data to the buffer
 }
 
 VertexBuffer::~VertexBuffer()
 {
-	GLCall(glDeleteBuffers(1, &m_RendererID));
+	if (m_Arena)
+		m_Arena->Free(m_Allocation);
+	else
+		GLStateCache::Get().DeleteBuffer(m_RendererID);
 }
 
 void VertexBuffer::Bind() const
 {
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));		// select the buffer
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, GetRendererID());		// select the buffer
 }
 
 void VertexBuffer::Unbind() const
 {
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));		// select the buffer
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, 0);		// select the buffer
+}
+
+void VertexBuffer::SetData(const void * data, unsigned int size)
+{
+	ASSERT(size <= m_Size);
+	if (m_Arena) {
+		m_Arena->SetData(m_Allocation, data, size);
+		return;
+	}
+
+	GLBuffer::SetData(m_RendererID, m_Size, nullptr, GL_DYNAMIC_DRAW);	// orphan
+	GLBuffer::SetSubData(m_RendererID, 0, size, data);
+}
+
+void VertexBuffer::SetSubData(const void * data, unsigned int size, unsigned int offset)
+{
+	ASSERT(offset + size <= m_Size);
+	if (m_Arena) {
+		m_Arena->SetData(m_Allocation, data, size, offset);
+		return;
+	}
+
+	GLBuffer::SetSubData(m_RendererID, offset, size, data);
+}
+
+unsigned int VertexBuffer::GetOffset() const
+{
+	return m_Arena ? m_Arena->Get(m_Allocation).offset : 0;
+}
+
+unsigned int VertexBuffer::GetRendererID() const
+{
+	return m_Arena ? m_Arena->Get(m_Allocation).buffer : m_RendererID;
 }
@@ -1,15 +1,35 @@
 #pragma once
 
+class BufferArena;
+
 class VertexBuffer
 {
 private:
 	unsigned int m_RendererID;		// opengl id
+	unsigned int m_Size;			// bytes
+	BufferArena* m_Arena;			// set for a view into an arena, which owns the GL buffer then
+	unsigned int m_Allocation;		// handle in m_Arena
 
 public:
 	/* param: size in bytes */
 	VertexBuffer(const void *data, unsigned int size);
+	/* an empty buffer that is rewritten every frame with SetData */
+	VertexBuffer(unsigned int size);
+	/* a view into arena: size bytes of one of its buffers, freed again with the view */
+	VertexBuffer(BufferArena& arena, const void* data, unsigned int size);
 	~VertexBuffer();
 	void Bind() const;
 	void Unbind() const;
 
+	/* replaces the first size bytes, orphaning the old storage so the GPU can keep reading it while we write
+	   (views can't orphan, their buffer is shared: they just write) */
+	void SetData(const void* data, unsigned int size);
+	/* writes size bytes at offset without orphaning, for filling a buffer in pieces */
+	void SetSubData(const void* data, unsigned int size, unsigned int offset);
+	inline unsigned int GetSize() const { return m_Size; }
+	/* where the data starts in the bound buffer, only views have one (it changes if the arena is defragmented) */
+	unsigned int GetOffset() const;
+	/* the GL buffer, the arena's for a view */
+	unsigned int GetRendererID() const;
+
 };
\ No newline at end of file
@@ -1,66 +1,168 @@
 #pragma once
+#include <array>
+#include <cstddef>
 #include <vector>
+#include <type_traits>
 #include <GL/glew.h>
 #include "Renderer.h"
+#include "VertexFormats.h"
 
 struct VertexBufferElement {
 
 	unsigned int type;
 	unsigned int count;
 	bool normalised;
+	bool integer;		// read with glVertexAttribIPointer, an ivec/uvec in the shader
 
-	static unsigned int GetSizeOfType(unsigned int type)
+	/* per component, packed types hold all components in one (see GetSize) */
+	static constexpr unsigned int GetSizeOfType(unsigned int type)
 	{
-		switch (type)
-		{
-			case GL_FLOAT:			return 4;
-			case GL_UNSIGNED_INT:	return 4;
-			case GL_UNSIGNED_BYTE: return 1;
-		}
-		ASSERT(false);
-		return 0;
+		return type == GL_FLOAT || type == GL_UNSIGNED_INT || type == GL_INT ? 4
+			: type == GL_UNSIGNED_SHORT || type == GL_SHORT || type == GL_HALF_FLOAT ? 2
+			: type == GL_UNSIGNED_BYTE || type == GL_BYTE ? 1
+			: type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV ? 4
+			: 0;
+	}
+	static constexpr bool IsPacked(unsigned int type)
+	{
+		return type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV;
+	}
+	/* bytes taken by count components of type */
+	static constexpr unsigned int GetSize(unsigned int type, unsigned int count)
+	{
+		return IsPacked(type) ? 4 : count * GetSizeOfType(type);
 	}
 };
 
+// GL type and component count of a vertex attribute's C++ type (or a vertex struct member's)
+template<typename T>
+struct VertexAttributeType {
+	static_assert(sizeof(T) == 0, "VertexAttributeType: no GL attribute type for this member");
+};
+template<> struct VertexAttributeType<float> { static constexpr unsigned int type = GL_FLOAT; static constexpr unsigned int count = 1; };
+template<> struct VertexAttributeType<int> { static constexpr unsigned int type = GL_INT; static constexpr unsigned int count = 1; };
+template<> struct VertexAttributeType<unsigned int> { static constexpr unsigned int type = GL_UNSIGNED_INT; static constexpr unsigned int count = 1; };
+template<> struct VertexAttributeType<short> { static constexpr unsigned int type = GL_SHORT; static constexpr unsigned int count = 1; };
+template<> struct VertexAttributeType<unsigned short> { static constexpr unsigned int type = GL_UNSIGNED_SHORT; static constexpr unsigned int count = 1; };
+template<> struct VertexAttributeType<signed char> { static constexpr unsigned int type = GL_BYTE; static constexpr unsigned int count = 1; };
+template<> struct VertexAttributeType<unsigned char> { static constexpr unsigned int type = GL_UNSIGNED_BYTE; static constexpr unsigned int count = 1; };
+template<> struct VertexAttributeType<Half> { static constexpr unsigned int type = GL_HALF_FLOAT; static constexpr unsigned int count = 1; };
+template<> struct VertexAttributeType<Packed1010102> { static constexpr unsigned int type = GL_INT_2_10_10_10_REV; static constexpr unsigned int count = 4; };
+template<typename T, size_t N>
+struct VertexAttributeType<T[N]> {
+	static constexpr unsigned int type = VertexAttributeType<T>::type;
+	static constexpr unsigned int count = (unsigned int)N * VertexAttributeType<T>::count;
+};
+
 
 class VertexBufferLayout {
 private:
 	std::vector<VertexBufferElement> m_Elements;
 	unsigned int m_Stride;
+	unsigned int m_Divisor;		// 0: per vertex, n: advances once every n instances
 
 public:
 	/* param: size in bytes */
-	VertexBufferLayout()
-		: m_Stride(0) {
-		
+	VertexBufferLayout(unsigned int divisor = 0)
+		: m_Stride(0), m_Divisor(divisor) {
+
 	}
 	~VertexBufferLayout() {};
-	
-	// Push:
+
+	// Push: count components of T, one of the types VertexAttributeType knows (anything else fails to compile).
+	// normalised: integer types read as 0..1 (unsigned) or -1..1 (signed) floats, otherwise they convert as they are.
+	// Packed1010102 is always 4 components
 	template<typename T>
-	void Push(unsigned int count)
+	void Push(unsigned int count, bool normalised = false)
 	{
-		static_assert(false);
+		const unsigned int type = VertexAttributeType<T>::type;
+		ASSERT(!VertexBufferElement::IsPacked(type) || 4 == count);
+		m_Elements.push_back({ type, count, normalised, false });
+		m_Stride += VertexBufferElement::GetSize(type, count);
 	}
-	template<>
-	void Push<float>(unsigned int count)
+
+	// integer attributes the shader reads as ints (ivec, uvec), not converted to float
+	template<typename T>
+	void PushInteger(unsigned int count)
 	{
-		m_Elements.push_back({ GL_FLOAT, count, GL_FALSE});
-		m_Stride += count * VertexBufferElement::GetSizeOfType(GL_FLOAT);
+		static_assert(std::is_integral<T>::value, "VertexBufferLayout::PushInteger: integer types only");
+		m_Elements.push_back({ VertexAttributeType<T>::type, count, false, true });
+		m_Stride += VertexBufferElement::GetSize(VertexAttributeType<T>::type, count);
 	}
-	template<>
-	void Push<unsigned int>(unsigned int count)
+
+	// a float matrix takes one attribute location per column, a mat4 is four vec4s in consecutive locations
+	void PushMatrix(unsigned int columns, unsigned int rows);
+
+	inline const std::vector<VertexBufferElement>& GetElements() const { return m_Elements; }
+	inline unsigned int GetStride() const { return m_Stride; }
+	inline unsigned int GetDivisor() const { return m_Divisor; }
+};
+
+inline void VertexBufferLayout::PushMatrix(unsigned int columns, unsigned int rows)
+{
+	for (unsigned int i = 0; i < columns; i++)
+		Push<float>(rows);
+}
+
+
+// compile time layouts, described from the vertex struct itself:
+//   struct Vertex { float position[2]; unsigned char colour[4]; };
+//   static constexpr auto layout = MakeVertexLayout<Vertex>(VERTEX_ATTRIBUTE(Vertex, position),
+//       VERTEX_ATTRIBUTE_NORMALISED(Vertex, colour));
+//   static_assert(layout.IsValid(), "Vertex layout");
+// Type, count and offset come from the member's declaration, the stride is sizeof(Vertex). Everything is a constant,
+// VertexArray::AddBuffer just walks the array. A member type with no GL equivalent doesn't compile, IsValid() catches
+// attributes that overlap, run past the struct or have more than 4 components.
+// Compressed members (Half, Packed1010102, normalised short/char) work the same way, see VertexFormats.h
+
+struct VertexAttribute {
+	unsigned int type;
+	unsigned int count;
+	bool normalised;
+	bool integer;
+	unsigned int offset;		// bytes from the start of the vertex
+};
+
+template<typename T>
+constexpr VertexAttribute MakeVertexAttribute(size_t offset, bool normalised, bool integer)
+{
+	return VertexAttribute{ VertexAttributeType<T>::type, VertexAttributeType<T>::count, normalised, integer, (unsigned int)offset };
+}
+
+#define VERTEX_ATTRIBUTE(Vertex, member) MakeVertexAttribute<decltype(Vertex::member)>(offsetof(Vertex, member), false, false)
+/* integer members read as 0..1 (or -1..1) floats */
+#define VERTEX_ATTRIBUTE_NORMALISED(Vertex, member) MakeVertexAttribute<decltype(Vertex::member)>(offsetof(Vertex, member), true, false)
+/* integer members read as ints */
+#define VERTEX_ATTRIBUTE_INTEGER(Vertex, member) MakeVertexAttribute<decltype(Vertex::member)>(offsetof(Vertex, member), false, true)
+
+template<size_t N>
+struct VertexLayout {
+	std::array<VertexAttribute, N> attributes;
+	unsigned int stride;
+	unsigned int divisor;		// as VertexBufferLayout's
+
+	/* single return statements, constexpr functions can't have more in VS2015 */
+	constexpr unsigned int EndOf(size_t i) const
 	{
-		m_Elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE });
-		m_Stride += count * VertexBufferElement::GetSizeOfType(GL_UNSIGNED_INT);
+		return attributes[i].offset + VertexBufferElement::GetSize(attributes[i].type, attributes[i].count);
 	}
-	template<>
-	void Push<unsigned char>(unsigned int count)
+	constexpr bool IsValid(size_t i = 0) const
 	{
-		m_Elements.push_back({ GL_UNSIGNED_BYTE, count, GL_FALSE });
-		m_Stride += count * VertexBufferElement::GetSizeOfType(GL_UNSIGNED_BYTE);
+		return i == N ? true
+			: attributes[i].count >= 1 && attributes[i].count <= 4 && EndOf(i) <= stride
+			&& (i == 0 || attributes[i].offset >= EndOf(i - 1)) && IsValid(i + 1);
 	}
+};
 
-	inline const std::vector<VertexBufferElement> GetElements() const { return m_Elements; }
-	inline unsigned int GetStride() const { return m_Stride; }
-};
\ No newline at end of file
+template<typename Vertex, typename... Attributes>
+constexpr VertexLayout<sizeof...(Attributes)> MakeVertexLayout(Attributes... attributes)
+{
+	return VertexLayout<sizeof...(Attributes)>{ { { attributes... } }, (unsigned int)sizeof(Vertex), 0 };
+}
+
+/* advances once per instance */
+template<typename Vertex, typename... Attributes>
+constexpr VertexLayout<sizeof...(Attributes)> MakeInstanceLayout(Attributes... attributes)
+{
+	return VertexLayout<sizeof...(Attributes)>{ { { attributes... } }, (unsigned int)sizeof(Vertex), 1 };
+}
@@ -0,0 +1,228 @@
+#include "VertexEncoder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// SSE2 is part of x64 and of /arch:SSE2 x86 builds, no CPU check needed
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define VERTEX_ENCODER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+	unsigned int FloatBits(float value)
+	{
+		unsigned int bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	float BitsFloat(unsigned int bits)
+	{
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	// Fabian Giesen's float -> half, round to nearest even. Values too small for a normal half are added to a magic
+	// number so the FPU does the rounding, the others round by adding to the bits
+	const unsigned int HalfMax = (127 + 16) << 23;				// this and up are infinity (or NaN)
+	const unsigned int HalfMinNormal = (127 - 14) << 23;
+	const unsigned int SubnormalMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+	const unsigned int NormalBias = 0xfff - ((127 - 15) << 23);	// rebias the exponent and round the mantissa
+
+	unsigned short FloatToHalf(float value)
+	{
+		unsigned int bits = FloatBits(value);
+		unsigned int sign = bits & 0x80000000u;
+		bits ^= sign;
+
+		unsigned int half;
+		if (bits >= HalfMax)
+			half = bits > 0x7f800000u ? 0x7e00 : 0x7c00;
+		else if (bits < HalfMinNormal)
+			half = FloatBits(BitsFloat(bits) + BitsFloat(SubnormalMagic)) - SubnormalMagic;
+		else
+			half = (bits + NormalBias + ((bits >> 13) & 1)) >> 13;
+		return (unsigned short)(half | (sign >> 16));
+	}
+
+	/* clamped to -1..1, times scale, rounded to nearest even like cvtps2dq */
+	int Quantize(float value, float scale)
+	{
+		return (int)std::lrint(std::min(std::max(value, -1.0f), 1.0f) * scale);
+	}
+
+	unsigned int PackNormal(int x, int y, int z)
+	{
+		return (x & 0x3ff) | (y & 0x3ff) << 10 | (z & 0x3ff) << 20;
+	}
+
+	const float* Advance(const float* values, unsigned int stride)
+	{
+		return (const float*)((const char*)values + stride);
+	}
+
+#ifdef VERTEX_ENCODER_SSE2
+	__m128i FloatToHalf(__m128 values)
+	{
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		__m128 sign = _mm_and_ps(values, signMask);
+		__m128 absolute = _mm_xor_ps(values, sign);
+		__m128i bits = _mm_castps_si128(absolute);
+
+		__m128i isNaN = _mm_castps_si128(_mm_cmpunord_ps(absolute, absolute));
+		__m128i isRegular = _mm_cmpgt_epi32(_mm_set1_epi32(HalfMax), bits);
+		__m128i special = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7c00));
+
+		__m128i isSubnormal = _mm_cmpgt_epi32(_mm_set1_epi32(HalfMinNormal), bits);
+		__m128i magic = _mm_set1_epi32(SubnormalMagic);
+		__m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absolute, _mm_castsi128_ps(magic))), magic);
+
+		__m128i odd = _mm_srai_epi32(_mm_slli_epi32(bits, 31 - 13), 31);		// -1 where the half's mantissa is odd
+		__m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(bits, _mm_set1_epi32(NormalBias)), odd), 13);
+
+		__m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+		__m128i half = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, special));
+		// the sign shifted arithmetically: negative results stay negative ints, so packs_epi32 keeps their low 16 bits
+		return _mm_or_si128(half, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+	}
+
+	__m128i Quantize(__m128 values, __m128 scale)
+	{
+		values = _mm_min_ps(_mm_max_ps(values, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+		return _mm_cvtps_epi32(_mm_mul_ps(values, scale));
+	}
+
+	/* x, y, z of a vertex, w = 0. Three loads, the vertex after the last one may not be there */
+	__m128 LoadVertex(const float* values)
+	{
+		return _mm_setr_ps(values[0], values[1], values[2], 0.0f);
+	}
+#endif
+
+}
+
+void VertexEncoder::EncodeHalf(const float* values, unsigned int count, Half* out)
+{
+	unsigned int i = 0;
+#ifdef VERTEX_ENCODER_SSE2
+	for (; i + 8 <= count; i += 8) {
+		__m128i low = FloatToHalf(_mm_loadu_ps(values + i));
+		__m128i high = FloatToHalf(_mm_loadu_ps(values + i + 4));
+		_mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(low, high));
+	}
+#endif
+	for (; i < count; i++)
+		out[i].bits = FloatToHalf(values[i]);
+}
+
+void VertexEncoder::EncodeSnorm16(const float* values, unsigned int count, short* out)
+{
+	unsigned int i = 0;
+#ifdef VERTEX_ENCODER_SSE2
+	const __m128 scale = _mm_set1_ps(32767.0f);
+	for (; i + 8 <= count; i += 8) {
+		__m128i low = Quantize(_mm_loadu_ps(values + i), scale);
+		__m128i high = Quantize(_mm_loadu_ps(values + i + 4), scale);
+		_mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(low, high));
+	}
+#endif
+	for (; i < count; i++)
+		out[i] = (short)Quantize(values[i], 32767.0f);
+}
+
+void VertexEncoder::EncodeSnorm8(const float* values, unsigned int count, signed char* out)
+{
+	unsigned int i = 0;
+#ifdef VERTEX_ENCODER_SSE2
+	const __m128 scale = _mm_set1_ps(127.0f);
+	for (; i + 16 <= count; i += 16) {
+		__m128i a = _mm_packs_epi32(Quantize(_mm_loadu_ps(values + i), scale), Quantize(_mm_loadu_ps(values + i + 4), scale));
+		__m128i b = _mm_packs_epi32(Quantize(_mm_loadu_ps(values + i + 8), scale), Quantize(_mm_loadu_ps(values + i + 12), scale));
+		_mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi16(a, b));
+	}
+#endif
+	for (; i < count; i++)
+		out[i] = (signed char)Quantize(values[i], 127.0f);
+}
+
+void VertexEncoder::EncodeNormals(const float* normals, unsigned int stride, unsigned int count, Packed1010102* out)
+{
+	unsigned int i = 0;
+#ifdef VERTEX_ENCODER_SSE2
+	// four normals transposed so each register holds one component of all of them, then packed side by side
+	const __m128 scale = _mm_set1_ps(511.0f);
+	const __m128i mask = _mm_set1_epi32(0x3ff);
+	for (; i + 4 <= count; i += 4) {
+		__m128 a = LoadVertex(normals);
+		__m128 b = LoadVertex(normals = Advance(normals, stride));
+		__m128 c = LoadVertex(normals = Advance(normals, stride));
+		__m128 d = LoadVertex(normals = Advance(normals, stride));
+		normals = Advance(normals, stride);
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+
+		__m128i x = _mm_and_si128(Quantize(a, scale), mask);
+		__m128i y = _mm_slli_epi32(_mm_and_si128(Quantize(b, scale), mask), 10);
+		__m128i z = _mm_slli_epi32(_mm_and_si128(Quantize(c, scale), mask), 20);
+		_mm_storeu_si128((__m128i*)(out + i), _mm_or_si128(x, _mm_or_si128(y, z)));
+	}
+#endif
+	for (; i < count; i++, normals = Advance(normals, stride))
+		out[i].bits = PackNormal(Quantize(normals[0], 511.0f), Quantize(normals[1], 511.0f), Quantize(normals[2], 511.0f));
+}
+
+void VertexEncoder::EncodePositions(const float* positions, unsigned int stride, unsigned int count, short* out,
+	float* scale, float* offset)
+{
+	float min[3] = { 0.0f, 0.0f, 0.0f };
+	float max[3] = { 0.0f, 0.0f, 0.0f };
+	const float* position = positions;
+	for (unsigned int i = 0; i < count; i++, position = Advance(position, stride)) {
+		for (int c = 0; c < 3; c++) {
+			min[c] = i ? std::min(min[c], position[c]) : position[c];
+			max[c] = i ? std::max(max[c], position[c]) : position[c];
+		}
+	}
+
+	// a flat box (all on one plane) keeps that axis at 0 instead of dividing by 0
+	float inverse[3];
+	for (int c = 0; c < 3; c++) {
+		offset[c] = (min[c] + max[c]) * 0.5f;
+		scale[c] = (max[c] - min[c]) * 0.5f;
+		inverse[c] = scale[c] > 0.0f ? 1.0f / scale[c] : 0.0f;
+	}
+
+	unsigned int i = 0;
+	position = positions;
+#ifdef VERTEX_ENCODER_SSE2
+	// w comes out as 1 - LoadVertex gives 0, the centre's w is -1
+	const __m128 centre = _mm_setr_ps(offset[0], offset[1], offset[2], -1.0f);
+	const __m128 toUnit = _mm_setr_ps(inverse[0], inverse[1], inverse[2], 1.0f);
+	const __m128 toSnorm = _mm_set1_ps(32767.0f);
+	for (; i + 2 <= count; i += 2) {
+		__m128 a = _mm_mul_ps(_mm_sub_ps(LoadVertex(position), centre), toUnit);
+		__m128 b = _mm_mul_ps(_mm_sub_ps(LoadVertex(position = Advance(position, stride)), centre), toUnit);
+		position = Advance(position, stride);
+		_mm_storeu_si128((__m128i*)(out + i * 4), _mm_packs_epi32(Quantize(a, toSnorm), Quantize(b, toSnorm)));
+	}
+#endif
+	for (; i < count; i++, position = Advance(position, stride)) {
+		for (int c = 0; c < 3; c++)
+			out[i * 4 + c] = (short)Quantize((position[c] - offset[c]) * inverse[c], 32767.0f);
+		out[i * 4 + 3] = 32767;
+	}
+}
+
+float VertexEncoder::DecodeHalf(Half value)
+{
+	unsigned int sign = (value.bits & 0x8000u) << 16;
+	unsigned int exponent = (value.bits >> 10) & 0x1f;
+	unsigned int mantissa = value.bits & 0x3ff;
+	if (0 == exponent)
+		return BitsFloat(sign | FloatBits(mantissa * (1.0f / (1 << 24))));		// subnormal, or 0
+	if (0x1f == exponent)
+		return BitsFloat(sign | 0x7f800000u | mantissa << 13);					// infinity, NaN
+	return BitsFloat(sign | (exponent + 127 - 15) << 23 | mantissa << 13);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "VertexFormats.h"
+
+// quantizes float vertex data into the compressed attribute formats (CPU only, no GL), 4 values at a time with SSE2
+// where the compiler targets it. Results are the same with and without SSE2:
+//  - EncodeHalf: round to nearest even, overflow goes to infinity, NaN stays NaN
+//  - EncodeSnorm16/8: clamped to -1..1, scaled by 32767 / 127 and rounded, what GL reads back with normalised = true
+//  - EncodeNormals: unit vectors into GL_INT_2_10_10_10_REV (10 bits a component, w = 0)
+//  - EncodePositions: snorm16 relative to the bounding box, the shader scales and offsets them back
+// A 32 byte vertex (position 3, normal 3, uv 2 floats) becomes 16: short position[4], Packed1010102 normal, Half uv[2].
+class VertexEncoder
+{
+public:
+	static void EncodeHalf(const float* values, unsigned int count, Half* out);
+	static void EncodeSnorm16(const float* values, unsigned int count, short* out);
+	static void EncodeSnorm8(const float* values, unsigned int count, signed char* out);
+
+	/* normals: x, y, z of vertex 0, the next vertex's stride bytes further. Should be unit length, components are
+	   clamped to -1..1 */
+	static void EncodeNormals(const float* normals, unsigned int stride, unsigned int count, Packed1010102* out);
+	/* positions as normals. out gets x, y, z, 1 as snorm16 per vertex; position = out.xyz * scale + offset (3 floats
+	   each) gets them back to within half a step of 1/32767 of the box */
+	static void EncodePositions(const float* positions, unsigned int stride, unsigned int count, short* out,
+		float* scale, float* offset);
+
+	static float DecodeHalf(Half value);
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+// compressed vertex attribute storage types, for vertex structs and VertexBufferLayout::Push. Fill them with
+// VertexEncoder
+
+// IEEE 754 half precision float (GL_HALF_FLOAT)
+struct Half {
+	unsigned short bits;
+};
+
+// x, y, z as signed 10 bit, w as signed 2 bit, x in the low bits (GL_INT_2_10_10_10_REV). Always 4 components,
+// normalised it reads as a vec4 in -1..1 - a normal or tangent in 4 bytes instead of 12
+struct Packed1010102 {
+	unsigned int bits;
+};
@@ -0,0 +1,63 @@
+#include "WindowContext.h"
+#include "Renderer.h"
+#include <GLFW/glfw3.h>	// would use EGL with OpenGLES?
+
+WindowContext::WindowContext(GLFWwindow * window, int width, int height)
+	: GLContext(width, height), m_Window(window)
+{
+}
+
+WindowContext::~WindowContext()
+{
+	glfwTerminate();
+}
+
+WindowContext * WindowContext::Create(int width, int height, const char * title)
+{
+	/* Initialize the library */
+	if (!glfwInit())
+		return nullptr;
+
+	/* Explicitly ask for the compatibility profile for OpenGL Context - this is the default anyway */
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef _DEBUG
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);	// drivers only promise debug messages in a debug context
+#endif
+
+	/* Create a windowed mode window and its OpenGL context */
+	GLFWwindow* window = glfwCreateWindow(width, height, title, NULL, NULL);	// creates a window AND it's openGL context
+	if (!window)
+	{
+		ASSERT(false);
+		glfwTerminate();
+		return nullptr;
+	}
+
+	/* Make the window's context current */
+	glfwMakeContextCurrent(window);
+	return new WindowContext(window, width, height);
+}
+
+bool WindowContext::ShouldClose() const
+{
+	return glfwWindowShouldClose(m_Window) != 0;
+}
+
+void WindowContext::SwapBuffers()
+{
+	/* Swap front and back buffers */
+	GLCall(glfwSwapBuffers(m_Window));
+}
+
+void WindowContext::PollEvents()
+{
+	/* Poll for and process events */
+	GLCall(glfwPollEvents());
+}
+
+void WindowContext::SetVSync(bool enabled)
+{
+	glfwSwapInterval(enabled ? 1 : 0);
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "GLContext.h"
+
+struct GLFWwindow;
+
+// a GLFW window and its context
+class WindowContext : public GLContext
+{
+private:
+	GLFWwindow* m_Window;
+
+	WindowContext(GLFWwindow* window, int width, int height);
+
+public:
+	~WindowContext();
+
+	/* nullptr if GLFW or the window couldn't be created */
+	static WindowContext* Create(int width, int height, const char* title);
+
+	bool IsHeadless() const override { return false; }
+	bool ShouldClose() const override;
+	void SwapBuffers() override;
+	void PollEvents() override;
+	void SetVSync(bool enabled) override;
+};